@@ -0,0 +1,176 @@
+#include "asset_pack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::vector<std::shared_ptr<AssetPack>> mounted;
+
+uint64_t asset_path_hash(std::string_view path) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : path) {
+        hash ^= static_cast<uint8_t>(c == '\\' ? '/' : c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t asset_path_check(std::string_view path) {
+    // multiply-xorshift per byte with a murmur3 finalizer, unlike FNV so the two rarely collide
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ path.size();
+    for (char c : path) {
+        hash ^= static_cast<uint8_t>(c == '\\' ? '/' : c);
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 29;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+AssetPack::AssetPack(const std::string &path) {
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("failed to open asset pack " + path);
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        base = static_cast<const std::byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open asset pack " + path);
+    struct stat st;
+    fstat(fd, &st);
+    length = static_cast<size_t>(st.st_size);
+    void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+        base = static_cast<const std::byte *>(p);
+#endif
+
+    auto fail = [&](const std::string &why) {
+        unmap();
+        throw std::runtime_error("asset pack " + path + ": " + why);
+    };
+    if (!base)
+        fail("failed to map");
+    if (length < sizeof(PackHeader))
+        fail("truncated");
+
+    PackHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION)
+        fail("not a version " + std::to_string(PACK_VERSION) + " pack");
+    if (sizeof(PackHeader) + size_t(header.count) * sizeof(PackEntry) > length)
+        fail("index is truncated");
+
+    // the header is 16 bytes, so the index is suitably aligned inside the page-aligned mapping
+    index = {reinterpret_cast<const PackEntry *>(base + sizeof(PackHeader)), header.count};
+    for (auto &e : index) {
+        if (e.offset > length || e.size > length - e.offset)
+            fail("entry out of bounds");
+    }
+}
+
+AssetPack::~AssetPack() { unmap(); }
+
+void AssetPack::unmap() {
+#ifdef _WIN32
+    if (base)
+        UnmapViewOfFile(base);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file)
+        CloseHandle(file);
+    mapping = file = nullptr;
+#else
+    if (base)
+        munmap(const_cast<std::byte *>(base), length);
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+#endif
+    base = nullptr;
+}
+
+std::optional<std::span<const std::byte>> AssetPack::find(std::string_view path) const {
+    auto hash = asset_path_hash(path);
+    auto it = std::lower_bound(index.begin(), index.end(), hash,
+                               [](const PackEntry &e, uint64_t h) { return e.hash < h; });
+    if (it == index.end() || it->hash != hash || it->check != asset_path_check(path))
+        return std::nullopt;
+    return std::span(base + it->offset, it->size);
+}
+
+std::vector<std::byte> write_asset_pack(std::span<const PackInput> inputs) {
+    std::vector<PackEntry> index;
+    index.reserve(inputs.size());
+    for (auto &in : inputs)
+        index.push_back({asset_path_hash(in.path), asset_path_check(in.path), 0, in.data.size()});
+
+    // payloads keep the input order, the index is sorted by hash for the binary search
+    size_t offset = sizeof(PackHeader) + index.size() * sizeof(PackEntry);
+    for (auto &e : index) {
+        offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+        e.offset = offset;
+        offset += e.size;
+    }
+
+    std::vector<std::byte> out(offset);
+    for (size_t i = 0; i < inputs.size(); ++i)
+        std::memcpy(out.data() + index[i].offset, inputs[i].data.data(), inputs[i].data.size());
+
+    std::vector<size_t> order(index.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return index[a].hash < index[b].hash; });
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (index[order[i]].hash == index[order[i - 1]].hash)
+            throw std::runtime_error("path hash collision between " + inputs[order[i]].path +
+                                     " and " + inputs[order[i - 1]].path);
+    }
+
+    PackHeader header{PACK_MAGIC, PACK_VERSION, static_cast<uint32_t>(index.size()),
+                      static_cast<uint32_t>(PACK_ALIGNMENT)};
+    std::memcpy(out.data(), &header, sizeof(header));
+    for (size_t i = 0; i < order.size(); ++i)
+        std::memcpy(out.data() + sizeof(PackHeader) + i * sizeof(PackEntry), &index[order[i]],
+                    sizeof(PackEntry));
+    return out;
+}
+
+void mount_asset_pack(std::shared_ptr<AssetPack> pack) { mounted.push_back(std::move(pack)); }
+
+AssetData load_asset(const std::string &path) {
+    for (auto it = mounted.rbegin(); it != mounted.rend(); ++it) {
+        if (auto bytes = (*it)->find(path))
+            return {*bytes, *it};
+    }
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        throw std::runtime_error("Failed to open " + path);
+    auto file = std::make_shared<std::vector<std::byte>>(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(file->data()), file->size());
+    return {*file, file};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pack layout: PackHeader, then `count` PackEntry records sorted by path hash, then the payloads,
+// each starting on a PACK_ALIGNMENT boundary so they can be used straight from the mapping.
+
+constexpr uint32_t PACK_MAGIC = 0x4B504346; // "FCPK"
+constexpr uint32_t PACK_VERSION = 2;
+constexpr size_t PACK_ALIGNMENT = 64;
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t alignment;
+};
+
+struct PackEntry {
+    uint64_t hash;
+    uint64_t check; // second, unrelated hash of the path so absent paths don't match on `hash`
+    uint64_t offset;
+    uint64_t size;
+};
+
+// FNV-1a over the path with backslashes folded into slashes, so lookups match on every platform.
+uint64_t asset_path_hash(std::string_view path);
+// Independent of asset_path_hash, stored next to it and compared by AssetPack::find.
+uint64_t asset_path_check(std::string_view path);
+
+/**
+ * \brief Read-only memory mapping of an asset pack. Lookups binary search the index and return
+ * spans into the mapping, so loading an asset costs page faults instead of file reads.
+ */
+class AssetPack {
+  private:
+    const std::byte *base = nullptr;
+    size_t length = 0;
+    std::span<const PackEntry> index;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    void unmap();
+
+  public:
+    // Maps the pack at `path`, throws std::runtime_error if it can't be opened or is malformed.
+    explicit AssetPack(const std::string &path);
+    ~AssetPack();
+
+    std::optional<std::span<const std::byte>> find(std::string_view path) const;
+    size_t size() const { return index.size(); }
+    size_t bytes() const { return length; }
+
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+};
+
+struct PackInput {
+    std::string path; // as it will be looked up at runtime, e.g. "assets/background.ktx2"
+    std::vector<std::byte> data;
+};
+
+// Serializes `inputs` into a pack, throws std::runtime_error on a path hash collision.
+std::vector<std::byte> write_asset_pack(std::span<const PackInput> inputs);
+
+/**
+ * \brief Bytes of one asset plus whatever keeps them alive, either the pack mapping or a buffer
+ * the loose file was read into. `owner` can be aliased into upload requests as is.
+ */
+struct AssetData {
+    std::span<const std::byte> bytes;
+    std::shared_ptr<const void> owner;
+};
+
+// Mounts a pack that load_asset checks before falling back to loose files.
+void mount_asset_pack(std::shared_ptr<AssetPack> pack);
+// Looks `path` up in the mounted packs (most recent first), then on disk. Throws if neither has it.
+AssetData load_asset(const std::string &path);
@@ -1,43 +1,20 @@
 #pragma once
 
-// clang-format off
-#include "stb/stb_image.h"
-#include "main.h"
-// clang-format on
 #include "graphics.h"
+#include "main.h"
 #include "module_registry.h"
+#include "render_passes.h"
+#include "opengl_helpers/fullscreen_pass.hpp"
 #include "opengl_helpers/program.hpp"
 #include "opengl_helpers/shader_manager.hpp"
+#include "opengl_helpers/texture_manager.hpp"
 #include <memory>
 #include <spdlog/spdlog.h>
 
 namespace l = spdlog;
 
-struct Vertex {
-    glm::vec3 pos;
-    glm::vec2 uv;
-};
-
-const std::vector<Vertex> quadVerts = {
-    {{-1, -1, 0}, {0, 0}}, {{1, -1, 0}, {1, 0}}, {{1, 1, 0}, {1, 1}},
-    {{-1, -1, 0}, {0, 0}}, {{1, 1, 0}, {1, 1}},  {{-1, 1, 0}, {0, 1}},
-};
-
 class BackgroundRenderer {
   private:
-    static constexpr const char *VERTEX_SHADER_SOURCE = R"(
-#version 450 core
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec2 uv;
-
-out vec2 vUV;
-
-void main() {
-    vUV = uv;
-    gl_Position = vec4(position, 1.0);
-}
-)";
-
     static constexpr const char *FRAGMENT_SHADER_SOURCE = R"(
 #version 450 core
 in vec2 vUV;
@@ -51,70 +28,45 @@ void main() {
 )";
 
     std::unique_ptr<GLProgram> program;
-    GLuint vao;
-    GLuint vbo;
-    GLuint tex;
+    TextureHandle texture;
 
   public:
     BackgroundRenderer() {
-        auto vs =
-            ShaderManager::get().getShader("quad_vertex", GL_VERTEX_SHADER, VERTEX_SHADER_SOURCE);
-        auto fs = ShaderManager::get().getShader("quad_fragment", GL_FRAGMENT_SHADER,
+        auto fs = ShaderManager::get().getShader("background_fragment", GL_FRAGMENT_SHADER,
                                                  FRAGMENT_SHADER_SOURCE);
-        program = std::make_unique<GLProgram>(*vs, *fs);
-
-        glCreateBuffers(1, &vbo);
-        glNamedBufferStorage(vbo, quadVerts.size() * sizeof(Vertex), quadVerts.data(), 0);
-
-        // --- VAO setup ---
-        glCreateVertexArrays(1, &vao);
-        glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-        // pos @ loc 0
-        glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
-        glEnableVertexArrayAttrib(vao, 0);
-        glVertexArrayAttribBinding(vao, 0, 0);
-        // uv @ loc 1
-        glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
-        glEnableVertexArrayAttrib(vao, 1);
-        glVertexArrayAttribBinding(vao, 1, 0);
-
-        // --- load texture ---
-        stbi_set_flip_vertically_on_load(true);
-        int w, h, ch;
-        auto *data = stbi_load("assets/background.png", &w, &h, &ch, 4);
-        if (!data)
-            throw std::runtime_error("Failed to load texture");
-
-        glCreateTextures(GL_TEXTURE_2D, 1, &tex);
-        glTextureStorage2D(tex, 1, GL_RGBA8, w, h);
-        glTextureSubImage2D(tex, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateTextureMipmap(tex);
-
-        glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        stbi_image_free(data);
+        program = FullscreenPass::makeProgram(*fs);
+
+        // the KTX2 built by asset_tool carries its mips and needs no decoding, the PNG is the
+        // fallback when it's missing or its format isn't supported here
+        TextureParams params{.sampler = {.wrapS = GL_CLAMP_TO_EDGE, .wrapT = GL_CLAMP_TO_EDGE}};
+        try {
+            texture = TextureManager::get().load("assets/background.ktx2", params);
+        } catch (const std::exception &e) {
+            l::warn("{}, falling back to the PNG background", e.what());
+            texture = TextureManager::get().load("assets/background.png", params);
+        }
 
-        program->use();
-        GLint loc = glGetUniformLocation(program->get(), "uTexture");
-        if (loc < 0) {
+        auto uTexture = program->uniform("uTexture");
+        if (!uTexture.valid()) {
             throw std::runtime_error("uTexture uniform not found");
         }
-        program->setUniform(loc, 0);
+        program->set(uTexture, 0);
     }
 
-    ~BackgroundRenderer() {
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+    // Everything the output depends on, 0 until the texture has streamed in.
+    uint64_t inputs() const {
+        if (!texture.ready())
+            return 0;
+        return hash_combine(program->get(), texture.get());
     }
 
     void render() const {
+        if (!texture.ready())
+            return;
         program->use();
-        glBindTextureUnit(0, tex);
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        texture.bind(0);
+        FullscreenPass::draw();
+        glBindSampler(0, 0);
     }
 
     BackgroundRenderer(const BackgroundRenderer &) = delete;
@@ -126,7 +78,12 @@ void main() {
 void background_module(Registry &reg, State &ctx) {
     try {
         auto renderer = std::make_shared<BackgroundRenderer>();
-        reg.add_render_pass([renderer]() { renderer->render(); });
+        // static and covers the whole window, so it's drawn once and the clear under it skipped
+        reg.add_render_pass({
+            .draw = [renderer]() { renderer->render(); },
+            .inputs = [renderer]() { return renderer->inputs(); },
+            .opaque = true,
+        });
     } catch (const std::exception &e) {
         l::error("Failed to create background renderer: {}", e.what());
         return;
@@ -0,0 +1,93 @@
+#include "asset_pack.h"
+#include "benchmark.h"
+#include "image_decode.h"
+#include "jobs.h"
+#include "qoi.h"
+#include "stb/stb_image.h"
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Decode throughput of the same image stored as PNG, QOI and raw RGBA, plus a batch decoded
+// serially versus spread over the job system the way TextureManager loads it.
+
+static constexpr const char *SOURCE_IMAGE = "assets/background.png";
+static constexpr size_t BATCH_SIZE = 16;
+
+struct DecodeInputs {
+    AssetData png;
+    AssetData qoi;
+    AssetData raw;
+    size_t pixel_bytes = 0;
+};
+
+static AssetData own_bytes(std::vector<std::byte> bytes) {
+    auto owner = std::make_shared<std::vector<std::byte>>(std::move(bytes));
+    return {std::span<const std::byte>(*owner), owner};
+}
+
+// Built once from the PNG so all formats decode identical pixels.
+static const DecodeInputs &decode_inputs() {
+    static DecodeInputs inputs = []() {
+        DecodeInputs in;
+        in.png = load_asset(SOURCE_IMAGE);
+
+        stbi_set_flip_vertically_on_load_thread(0);
+        int w, h, ch;
+        auto *data = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(in.png.bytes.data()),
+                                           static_cast<int>(in.png.bytes.size()), &w, &h, &ch, 4);
+        if (!data)
+            throw std::runtime_error(std::string("failed to decode ") + SOURCE_IMAGE);
+        std::vector<std::byte> pixels(reinterpret_cast<std::byte *>(data),
+                                      reinterpret_cast<std::byte *>(data) + size_t(w) * h * 4);
+        stbi_image_free(data);
+
+        in.pixel_bytes = pixels.size();
+        in.qoi = own_bytes(qoi_encode(pixels, w, h));
+        // row order doesn't matter for timing, a single level keeps it comparable with the others
+        in.raw = own_bytes(write_raw_image(w, h, false, std::span(&pixels, 1)));
+        return in;
+    }();
+    return inputs;
+}
+
+static void decode_loop(BenchState &state, const AssetData &asset) {
+    state.set_bytes_per_iteration(decode_inputs().pixel_bytes);
+    while (state.keep_running()) {
+        auto img = decode_image(asset);
+        if (img.levels.empty())
+            throw std::runtime_error("decode produced no levels");
+    }
+}
+
+static void decode_png(BenchState &state) { decode_loop(state, decode_inputs().png); }
+static void decode_qoi(BenchState &state) { decode_loop(state, decode_inputs().qoi); }
+// raw images are used in place, so this only measures header validation
+static void decode_raw(BenchState &state) { decode_loop(state, decode_inputs().raw); }
+
+static void decode_batch_serial(BenchState &state) {
+    auto &png = decode_inputs().png;
+    state.set_bytes_per_iteration(decode_inputs().pixel_bytes * BATCH_SIZE);
+    while (state.keep_running()) {
+        for (size_t i = 0; i < BATCH_SIZE; ++i)
+            decode_image(png);
+    }
+}
+
+static void decode_batch_parallel(BenchState &state) {
+    auto &png = decode_inputs().png;
+    state.set_bytes_per_iteration(decode_inputs().pixel_bytes * BATCH_SIZE);
+    while (state.keep_running()) {
+        std::vector<std::future<DecodedImage>> images;
+        for (size_t i = 0; i < BATCH_SIZE; ++i)
+            images.push_back(JobSystem::get().submit([&png]() { return decode_image(png); }));
+        for (auto &img : images)
+            img.get();
+    }
+}
+
+REGISTER_BENCHMARK(decode_png);
+REGISTER_BENCHMARK(decode_qoi);
+REGISTER_BENCHMARK(decode_raw);
+REGISTER_BENCHMARK(decode_batch_serial);
+REGISTER_BENCHMARK(decode_batch_parallel);
@@ -0,0 +1,106 @@
+#include "benchmark.h"
+#include "image_decode.h"
+#include "image_kernels.h"
+#include <random>
+#include <vector>
+
+// Every image kernel at each SIMD level on the same 1024x1024 image, so the scalar rows are the
+// baseline for the others. Throughput is in source bytes.
+
+static constexpr uint32_t SIZE = 1024;
+static constexpr size_t PIXELS = size_t(SIZE) * SIZE;
+
+static const std::vector<uint8_t> &source_pixels() {
+    static const auto pixels = [] {
+        std::vector<uint8_t> p(PIXELS * 4);
+        std::mt19937 rng(42);
+        for (auto &v : p)
+            v = static_cast<uint8_t>(rng());
+        return p;
+    }();
+    return pixels;
+}
+
+static void mip_box(BenchState &state, SimdLevel level, bool srgb) {
+    auto &k = kernels_for(level, image_kernels);
+    std::vector<uint8_t> dst(PIXELS);
+    state.set_bytes_per_iteration(PIXELS * 4);
+    while (state.keep_running())
+        k.downsample_box(source_pixels().data(), SIZE, SIZE, dst.data(), 0, SIZE / 2, srgb);
+}
+
+static void mip_kaiser(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, image_kernels);
+    std::vector<float> src(PIXELS * 4), dst(PIXELS);
+    k.decode_rgba8(source_pixels().data(), src.data(), PIXELS, false);
+    state.set_bytes_per_iteration(PIXELS * 16);
+    while (state.keep_running())
+        k.downsample_kaiser(src.data(), SIZE, SIZE, dst.data(), 0, SIZE / 2);
+}
+
+static void srgb_roundtrip(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, image_kernels);
+    std::vector<float> linear(PIXELS * 4);
+    std::vector<uint8_t> out(PIXELS * 4);
+    state.set_bytes_per_iteration(PIXELS * 4);
+    while (state.keep_running()) {
+        k.decode_rgba8(source_pixels().data(), linear.data(), PIXELS, true);
+        k.encode_rgba8(linear.data(), out.data(), PIXELS, true);
+    }
+}
+
+static void premultiply(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, image_kernels);
+    auto pixels = source_pixels();
+    state.set_bytes_per_iteration(PIXELS * 4);
+    // premultiplying twice just darkens further, the work per pixel stays the same
+    while (state.keep_running())
+        k.premultiply_alpha(pixels.data(), PIXELS, false);
+}
+
+static void rgb_to_rgba(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, image_kernels);
+    std::vector<uint8_t> dst(PIXELS * 4);
+    state.set_bytes_per_iteration(PIXELS * 3);
+    while (state.keep_running())
+        k.rgb_to_rgba(source_pixels().data(), dst.data(), PIXELS);
+}
+
+// The full chain as the texture loader builds it: best kernels, spread over the job system.
+static void mip_chain_box(BenchState &state) {
+    auto *base = reinterpret_cast<const std::byte *>(source_pixels().data());
+    state.set_bytes_per_iteration(PIXELS * 4);
+    while (state.keep_running())
+        build_mip_levels(base, SIZE, SIZE, true, MipFilter::box);
+}
+
+static void mip_chain_kaiser(BenchState &state) {
+    auto *base = reinterpret_cast<const std::byte *>(source_pixels().data());
+    state.set_bytes_per_iteration(PIXELS * 4);
+    while (state.keep_running())
+        build_mip_levels(base, SIZE, SIZE, true, MipFilter::kaiser);
+}
+
+static void mip_box_linear(BenchState &state, SimdLevel level) { mip_box(state, level, false); }
+static void mip_box_srgb(BenchState &state, SimdLevel level) { mip_box(state, level, true); }
+
+SIMD_BENCHMARK(mip_box_scalar, scalar, mip_box_linear);
+SIMD_BENCHMARK(mip_box_sse41, sse41, mip_box_linear);
+SIMD_BENCHMARK(mip_box_avx2, avx2, mip_box_linear);
+SIMD_BENCHMARK(mip_box_srgb_scalar, scalar, mip_box_srgb);
+SIMD_BENCHMARK(mip_box_srgb_sse41, sse41, mip_box_srgb);
+SIMD_BENCHMARK(mip_box_srgb_avx2, avx2, mip_box_srgb);
+SIMD_BENCHMARK(mip_kaiser_scalar, scalar, mip_kaiser);
+SIMD_BENCHMARK(mip_kaiser_sse41, sse41, mip_kaiser);
+SIMD_BENCHMARK(mip_kaiser_avx2, avx2, mip_kaiser);
+SIMD_BENCHMARK(srgb_roundtrip_scalar, scalar, srgb_roundtrip);
+SIMD_BENCHMARK(srgb_roundtrip_sse41, sse41, srgb_roundtrip);
+SIMD_BENCHMARK(srgb_roundtrip_avx2, avx2, srgb_roundtrip);
+SIMD_BENCHMARK(premultiply_scalar, scalar, premultiply);
+SIMD_BENCHMARK(premultiply_sse41, sse41, premultiply);
+SIMD_BENCHMARK(premultiply_avx2, avx2, premultiply);
+SIMD_BENCHMARK(rgb_to_rgba_scalar, scalar, rgb_to_rgba);
+SIMD_BENCHMARK(rgb_to_rgba_sse41, sse41, rgb_to_rgba);
+SIMD_BENCHMARK(rgb_to_rgba_avx2, avx2, rgb_to_rgba);
+REGISTER_BENCHMARK(mip_chain_box);
+REGISTER_BENCHMARK(mip_chain_kaiser);
@@ -0,0 +1,231 @@
+#include "benchmark.h"
+#include "math_kernels.h"
+#include <cmath>
+#include <fmt/core.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Every math kernel at each SIMD level against the same operation written with plain glm over
+// arrays of glm types, on 4096 elements so the working set stays in cache. Before the first row
+// runs, every level this CPU supports is checked against glm on the same inputs, so a fast but
+// wrong kernel fails every row instead of showing up as a win.
+
+static constexpr size_t COUNT = 4096;
+
+static float random_float(std::mt19937 &rng) {
+    return std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+}
+
+static glm::mat4 random_affine(std::mt19937 &rng) {
+    glm::mat4 m(1.0f);
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 3; ++r)
+            m[c][r] = random_float(rng);
+    }
+    return m;
+}
+
+static glm::quat random_quat(std::mt19937 &rng) {
+    return glm::normalize(
+        glm::quat(random_float(rng), random_float(rng), random_float(rng), random_float(rng)));
+}
+
+// The same inputs in both layouts, so the glm and kernel rows do identical work.
+struct MathInputs {
+    std::vector<glm::mat4> a, b;
+    std::vector<glm::vec3> points, mins, maxs;
+    std::vector<glm::quat> quats;
+    Mat4Array soa_a{COUNT}, soa_b{COUNT};
+    Vec3Array soa_points{COUNT};
+    AabbArray soa_boxes{COUNT};
+    QuatArray soa_quats{COUNT};
+
+    MathInputs() {
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < COUNT; ++i) {
+            a.push_back(random_affine(rng));
+            b.push_back(random_affine(rng));
+            points.emplace_back(random_float(rng), random_float(rng), random_float(rng));
+            glm::vec3 center(random_float(rng), random_float(rng), random_float(rng));
+            glm::vec3 extent(std::abs(random_float(rng)), std::abs(random_float(rng)), 0.5f);
+            mins.push_back(center - extent);
+            maxs.push_back(center + extent);
+            quats.push_back(random_quat(rng));
+
+            soa_a.set(i, a[i]);
+            soa_b.set(i, b[i]);
+            soa_points.set(i, points[i]);
+            soa_boxes.set(i, mins[i], maxs[i]);
+            soa_quats.set(i, quats[i]);
+        }
+    }
+};
+
+static void transform_aabb_glm(const glm::mat4 &m, const glm::vec3 &min, const glm::vec3 &max,
+                               glm::vec3 &out_min, glm::vec3 &out_max) {
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    glm::vec3 c(m * glm::vec4(center, 1.0f));
+    glm::vec3 e = glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y +
+                  glm::abs(glm::vec3(m[2])) * extent.z;
+    out_min = c - e;
+    out_max = c + e;
+}
+
+// FMA and a different order of additions only move the last few bits.
+static constexpr float TOLERANCE = 1e-5f;
+
+template <typename T>
+static void expect_near(const char *kernel, SimdLevel level, size_t i, const T &got,
+                        const T &want) {
+    for (int k = 0; k < T::length(); ++k) {
+        if (!(std::abs(got[k] - want[k]) <= TOLERANCE * (1.0f + std::abs(want[k]))))
+            throw std::runtime_error(fmt::format("{} {} disagrees with glm at element {}", kernel,
+                                                 simd_level_to_string(level), i));
+    }
+}
+
+static void expect_near(const char *kernel, SimdLevel level, size_t i, const glm::mat4 &got,
+                        const glm::mat4 &want) {
+    for (int c = 0; c < 4; ++c)
+        expect_near(kernel, level, i, got[c], want[c]);
+}
+
+// Throws unless every kernel at every supported level matches glm on `in`.
+static void verify_math_kernels(MathInputs &in) {
+    Mat4Array mats(COUNT);
+    Vec3Array points(COUNT);
+    AabbArray boxes(COUNT);
+    for (int l = 0; l <= int(best_simd_level()); ++l) {
+        auto level = SimdLevel(l);
+        auto &k = math_kernels(level);
+
+        k.mat_mul(in.soa_a.view(), in.soa_b.view(), mats.view(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            expect_near("mat_mul", level, i, mats.get(i), in.a[i] * in.b[i]);
+
+        k.transform_points(in.soa_a.view(), in.soa_points.view(), points.view(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            expect_near("transform_points", level, i, points.get(i),
+                        glm::vec3(in.a[i] * glm::vec4(in.points[i], 1.0f)));
+
+        k.transform_aabbs(in.soa_a.view(), in.soa_boxes.view(), boxes.view(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i) {
+            glm::vec3 min, max;
+            transform_aabb_glm(in.a[i], in.mins[i], in.maxs[i], min, max);
+            expect_near("transform_aabbs", level, i, boxes.min(i), min);
+            expect_near("transform_aabbs", level, i, boxes.max(i), max);
+        }
+
+        k.quat_to_mat(in.soa_quats.view(), mats.view(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            expect_near("quat_to_mat", level, i, mats.get(i), glm::mat4_cast(in.quats[i]));
+    }
+}
+
+static MathInputs &inputs() {
+    static MathInputs in;
+    // a throwing initializer runs again on the next call, so every row reports the failure
+    static bool verified = (verify_math_kernels(in), true);
+    (void)verified;
+    return in;
+}
+
+static void math_mat_mul_glm(BenchState &state) {
+    auto &in = inputs();
+    std::vector<glm::mat4> out(COUNT);
+    state.set_bytes_per_iteration(COUNT * sizeof(glm::mat4) * 2);
+    while (state.keep_running()) {
+        for (size_t i = 0; i < COUNT; ++i)
+            out[i] = in.a[i] * in.b[i];
+    }
+}
+
+static void math_transform_points_glm(BenchState &state) {
+    auto &in = inputs();
+    std::vector<glm::vec3> out(COUNT);
+    state.set_bytes_per_iteration(COUNT * (sizeof(glm::mat4) + sizeof(glm::vec3)));
+    while (state.keep_running()) {
+        for (size_t i = 0; i < COUNT; ++i)
+            out[i] = glm::vec3(in.a[i] * glm::vec4(in.points[i], 1.0f));
+    }
+}
+
+static void math_transform_aabbs_glm(BenchState &state) {
+    auto &in = inputs();
+    std::vector<glm::vec3> out_min(COUNT), out_max(COUNT);
+    state.set_bytes_per_iteration(COUNT * (sizeof(glm::mat4) + 2 * sizeof(glm::vec3)));
+    while (state.keep_running()) {
+        for (size_t i = 0; i < COUNT; ++i) {
+            transform_aabb_glm(in.a[i], in.mins[i], in.maxs[i], out_min[i], out_max[i]);
+        }
+    }
+}
+
+static void math_quat_to_mat_glm(BenchState &state) {
+    auto &in = inputs();
+    std::vector<glm::mat4> out(COUNT);
+    state.set_bytes_per_iteration(COUNT * sizeof(glm::quat));
+    while (state.keep_running()) {
+        for (size_t i = 0; i < COUNT; ++i)
+            out[i] = glm::mat4_cast(in.quats[i]);
+    }
+}
+
+static void mat_mul(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, math_kernels);
+    auto &in = inputs();
+    Mat4Array out(COUNT);
+    state.set_bytes_per_iteration(COUNT * sizeof(glm::mat4) * 2);
+    while (state.keep_running())
+        k.mat_mul(in.soa_a.view(), in.soa_b.view(), out.view(), COUNT);
+}
+
+static void transform_points(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, math_kernels);
+    auto &in = inputs();
+    Vec3Array out(COUNT);
+    state.set_bytes_per_iteration(COUNT * (sizeof(glm::mat4) + sizeof(glm::vec3)));
+    while (state.keep_running())
+        k.transform_points(in.soa_a.view(), in.soa_points.view(), out.view(), COUNT);
+}
+
+static void transform_aabbs(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, math_kernels);
+    auto &in = inputs();
+    AabbArray out(COUNT);
+    state.set_bytes_per_iteration(COUNT * (sizeof(glm::mat4) + 2 * sizeof(glm::vec3)));
+    while (state.keep_running())
+        k.transform_aabbs(in.soa_a.view(), in.soa_boxes.view(), out.view(), COUNT);
+}
+
+static void quat_to_mat(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, math_kernels);
+    auto &in = inputs();
+    Mat4Array out(COUNT);
+    state.set_bytes_per_iteration(COUNT * sizeof(glm::quat));
+    while (state.keep_running())
+        k.quat_to_mat(in.soa_quats.view(), out.view(), COUNT);
+}
+
+REGISTER_BENCHMARK(math_mat_mul_glm);
+SIMD_BENCHMARK(math_mat_mul_scalar, scalar, mat_mul);
+SIMD_BENCHMARK(math_mat_mul_sse41, sse41, mat_mul);
+SIMD_BENCHMARK(math_mat_mul_avx2, avx2, mat_mul);
+SIMD_BENCHMARK(math_mat_mul_avx512, avx512, mat_mul);
+REGISTER_BENCHMARK(math_transform_points_glm);
+SIMD_BENCHMARK(math_transform_points_scalar, scalar, transform_points);
+SIMD_BENCHMARK(math_transform_points_sse41, sse41, transform_points);
+SIMD_BENCHMARK(math_transform_points_avx2, avx2, transform_points);
+SIMD_BENCHMARK(math_transform_points_avx512, avx512, transform_points);
+REGISTER_BENCHMARK(math_transform_aabbs_glm);
+SIMD_BENCHMARK(math_transform_aabbs_scalar, scalar, transform_aabbs);
+SIMD_BENCHMARK(math_transform_aabbs_sse41, sse41, transform_aabbs);
+SIMD_BENCHMARK(math_transform_aabbs_avx2, avx2, transform_aabbs);
+SIMD_BENCHMARK(math_transform_aabbs_avx512, avx512, transform_aabbs);
+REGISTER_BENCHMARK(math_quat_to_mat_glm);
+SIMD_BENCHMARK(math_quat_to_mat_scalar, scalar, quat_to_mat);
+SIMD_BENCHMARK(math_quat_to_mat_sse41, sse41, quat_to_mat);
+SIMD_BENCHMARK(math_quat_to_mat_avx2, avx2, quat_to_mat);
+SIMD_BENCHMARK(math_quat_to_mat_avx512, avx512, quat_to_mat);
@@ -0,0 +1,64 @@
+#include "benchmark.h"
+#include "transforms.h"
+#include <random>
+#include <vector>
+
+// World matrix updates of a 100k node hierarchy, all of it versus 1% of the nodes moving, so the
+// two show how much of the full cost a partial update saves.
+
+static constexpr size_t NODES = 100000;
+
+struct BenchScene {
+    TransformHierarchy hierarchy;
+    std::vector<TransformId> roots;
+    std::vector<TransformId> moved; // every 100th node, spread over all depths
+};
+
+static BenchScene make_scene(const TransformKernels &kernels) {
+    BenchScene scene;
+    std::mt19937 rng(42);
+    std::vector<TransformId> all;
+    for (size_t i = 0; i < NODES; ++i) {
+        // about one root per 50 nodes, the rest hang off a random earlier node
+        TransformId parent = all.empty() || rng() % 50 == 0 ? TransformHierarchy::NONE
+                                                            : all[rng() % all.size()];
+        auto local = glm::mat4(1.0f);
+        local[3] = glm::vec4(static_cast<float>(rng() % 16), 1.0f, 0.0f, 1.0f);
+        auto id = scene.hierarchy.create(parent, local);
+        all.push_back(id);
+        if (parent == TransformHierarchy::NONE)
+            scene.roots.push_back(id);
+        if (i % 100 == 0)
+            scene.moved.push_back(id);
+    }
+    scene.hierarchy.update(kernels);
+    return scene;
+}
+
+static void touch(BenchScene &scene, const std::vector<TransformId> &ids) {
+    for (auto id : ids)
+        scene.hierarchy.set_local(id, scene.hierarchy.local(id));
+}
+
+static void transforms_all(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, transform_kernels);
+    auto scene = make_scene(k);
+    while (state.keep_running()) {
+        touch(scene, scene.roots);
+        scene.hierarchy.update(k);
+    }
+}
+
+static void transforms_one_percent(BenchState &state, SimdLevel level) {
+    auto &k = kernels_for(level, transform_kernels);
+    auto scene = make_scene(k);
+    while (state.keep_running()) {
+        touch(scene, scene.moved);
+        scene.hierarchy.update(k);
+    }
+}
+
+SIMD_BENCHMARK(transforms_all_scalar, scalar, transforms_all);
+SIMD_BENCHMARK(transforms_all_avx2, avx2, transforms_all);
+SIMD_BENCHMARK(transforms_one_percent_scalar, scalar, transforms_one_percent);
+SIMD_BENCHMARK(transforms_one_percent_avx2, avx2, transforms_one_percent);
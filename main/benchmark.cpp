@@ -0,0 +1,120 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <fstream>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+namespace l = spdlog;
+
+LaunchOptions parse_launch_options(int argc, char **argv) {
+    LaunchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--gl-profile=debug") {
+            opts.profile = GLProfile::debug;
+        } else if (arg == "--gl-profile=release") {
+            opts.profile = GLProfile::release;
+        } else if (arg.starts_with("--bench=")) {
+            opts.bench_frames = std::max(1, std::atoi(argv[i] + 8));
+        } else if (arg.starts_with("--bench-csv=")) {
+            opts.bench_csv = std::string(arg.substr(12));
+        } else if (arg == "--microbench") {
+            opts.microbench = true;
+        } else if (arg.starts_with("--microbench=")) {
+            opts.microbench = true;
+            opts.microbench_filter = std::string(arg.substr(13));
+        } else if (arg == "--hidden") {
+            opts.hidden = true;
+        } else {
+            l::warn("unknown argument: {}", arg);
+        }
+    }
+    return opts;
+}
+
+FrameBenchmark::FrameBenchmark(int frames, std::string csv) : frames(frames), csv(std::move(csv)) {
+    cpu_ms.reserve(frames);
+    gpu_ms.reserve(frames);
+    last = std::chrono::steady_clock::now();
+}
+
+void FrameBenchmark::begin_frame() { gpu.begin(); }
+
+void FrameBenchmark::end_frame() {
+    gpu.end();
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> took = now - last;
+    last = now;
+
+    if (seen++ < WARMUP_FRAMES)
+        return;
+    cpu_ms.push_back(took.count());
+    gpu_ms.push_back(gpu.ms());
+    perf_warnings += gl_debug_stats().perf_last_frame;
+}
+
+void FrameBenchmark::report(GLProfile profile) const {
+    auto sorted = cpu_ms;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        return sorted.empty() ? 0.0 : sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+    };
+    auto avg = [](const std::vector<double> &v) {
+        return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+    };
+
+    auto line = fmt::format("{},{},{:.3f},{:.3f},{:.3f},{:.3f},{}", gl_profile_to_string(profile),
+                            cpu_ms.size(), avg(cpu_ms), percentile(0.5), percentile(0.99),
+                            avg(gpu_ms), perf_warnings);
+    l::info("benchmark [{}] {} frames: cpu avg {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms, gpu avg "
+            "{:.3f} ms, {} perf warnings",
+            gl_profile_to_string(profile), cpu_ms.size(), avg(cpu_ms), percentile(0.5),
+            percentile(0.99), avg(gpu_ms), perf_warnings);
+
+    if (!csv.empty()) {
+        std::ofstream out(csv, std::ios::app);
+        if (!out) {
+            l::error("failed to open benchmark output: {}", csv);
+            return;
+        }
+        out << line << '\n';
+    }
+}
+
+bool BenchState::keep_running() {
+    auto now = std::chrono::steady_clock::now();
+    if (iterations == 0)
+        start = now;
+    seconds = std::chrono::duration<double>(now - start).count();
+    if (iterations >= MIN_ITERATIONS && seconds >= MIN_SECONDS)
+        return false;
+    iterations++;
+    return true;
+}
+
+std::vector<BenchResult> run_benchmarks(const std::string &filter) {
+    std::vector<BenchResult> results;
+    for (auto &[name, fn] : benchmark_list()) {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+            continue;
+        BenchState state;
+        try {
+            fn(state);
+        } catch (const std::exception &e) {
+            l::error("benchmark {} failed: {}", name, e.what());
+            continue;
+        }
+        // the final keep_running() call that ended the loop didn't start an iteration
+        size_t n = std::max<size_t>(1, state.iteration_count());
+        BenchResult r{name, n, state.elapsed() * 1e9 / n};
+        if (state.bytes_per_iteration() > 0 && state.elapsed() > 0)
+            r.mb_per_s = state.bytes_per_iteration() * double(n) / state.elapsed() / (1 << 20);
+        l::info("{:<32} {:>8} iters {:>14.0f} ns/iter {:>10.1f} MB/s", r.name, r.iterations,
+                r.ns_per_iter, r.mb_per_s);
+        results.push_back(std::move(r));
+    }
+    return results;
+}
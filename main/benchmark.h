@@ -0,0 +1,120 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "gl_debug.h"
+#include "opengl_helpers/gpu_timer.hpp"
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct LaunchOptions {
+#ifdef NDEBUG
+    GLProfile profile = GLProfile::release;
+#else
+    GLProfile profile = GLProfile::debug;
+#endif
+    int bench_frames = 0;  // > 0 runs the frame benchmark and exits
+    std::string bench_csv; // if set, results are appended here as well
+    bool microbench = false;      // runs the registered microbenchmarks and exits
+    std::string microbench_filter; // only those whose name contains this
+    bool hidden = false;           // no visible window, for runs on a headless display
+};
+
+/**
+ * \brief Parses --gl-profile=debug|release, --bench=<frames>, --bench-csv=<path>,
+ * --microbench[=<filter>] and --hidden.
+ */
+LaunchOptions parse_launch_options(int argc, char **argv);
+
+/**
+ * \brief Records CPU and GPU frame times over a fixed number of frames after a short warmup, then
+ * prints a summary tagged with the GL profile, so runs with different profiles can be compared.
+ */
+class FrameBenchmark {
+  private:
+    static constexpr int WARMUP_FRAMES = 60;
+
+    int frames;
+    int seen = 0;
+    std::string csv;
+    std::vector<double> cpu_ms;
+    std::vector<double> gpu_ms;
+    uint64_t perf_warnings = 0;
+    std::chrono::steady_clock::time_point last;
+    GpuTimer<> gpu;
+
+  public:
+    FrameBenchmark(int frames, std::string csv);
+
+    void begin_frame();
+    void end_frame();
+    bool done() const { return seen >= WARMUP_FRAMES + frames; }
+    void report(GLProfile profile) const;
+};
+
+/**
+ * \brief Passed to microbenchmarks, which loop on keep_running() around the code being measured.
+ * Timing starts with the first call, so setup before the loop isn't counted.
+ */
+class BenchState {
+  private:
+    static constexpr double MIN_SECONDS = 0.25;
+    static constexpr size_t MIN_ITERATIONS = 3;
+
+    size_t iterations = 0;
+    size_t bytes = 0;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0;
+
+  public:
+    bool keep_running();
+    // Reports throughput too, for benchmarks that process a known amount of data per iteration.
+    void set_bytes_per_iteration(size_t n) { bytes = n; }
+
+    size_t iteration_count() const { return iterations; }
+    double elapsed() const { return seconds; }
+    size_t bytes_per_iteration() const { return bytes; }
+};
+
+using BenchFn = std::function<void(BenchState &)>;
+
+struct BenchResult {
+    std::string name;
+    size_t iterations = 0;
+    double ns_per_iter = 0;
+    double mb_per_s = 0; // 0 if the benchmark didn't set bytes per iteration
+};
+
+inline std::vector<std::pair<std::string, BenchFn>> &benchmark_list() {
+    static std::vector<std::pair<std::string, BenchFn>> list;
+    return list;
+}
+
+// Runs every registered benchmark whose name contains `filter`, logging each result.
+std::vector<BenchResult> run_benchmarks(const std::string &filter = "");
+
+#define REGISTER_BENCHMARK(fn)                                                                     \
+    namespace {                                                                                    \
+    struct BenchRegistrar_##fn {                                                                   \
+        BenchRegistrar_##fn() { benchmark_list().emplace_back(#fn, fn); }                          \
+    } bench_registrar_##fn;                                                                        \
+    }
+
+/**
+ * \brief The kernel table `get` (image_kernels, math_kernels, ...) returns for `level`. Throws when
+ * this CPU can't run `level`, because `get` would quietly hand out a lower one and the row would
+ * measure the wrong kernels.
+ */
+template <typename Get> decltype(auto) kernels_for(SimdLevel level, Get get) {
+    if (level > best_simd_level())
+        throw std::runtime_error(std::string(simd_level_to_string(level)) +
+                                 " isn't supported on this CPU");
+    return get(level);
+}
+
+// Registers `name` as call(state, SimdLevel::level), for benchmarks repeated per SIMD level.
+#define SIMD_BENCHMARK(name, level, call)                                                          \
+    static void name(BenchState &state) { call(state, SimdLevel::level); }                         \
+    REGISTER_BENCHMARK(name)
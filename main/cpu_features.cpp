@@ -0,0 +1,91 @@
+#include "cpu_features.h"
+#include <cstdint>
+
+#if CPU_X86 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#elif CPU_X86
+#include <cpuid.h>
+#endif
+
+#if CPU_X86
+static void cpuid(int leaf, int subleaf, uint32_t out[4]) {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, leaf, subleaf);
+    for (int i = 0; i < 4; ++i)
+        out[i] = static_cast<uint32_t>(regs[i]);
+#else
+    __cpuid_count(leaf, subleaf, out[0], out[1], out[2], out[3]);
+#endif
+}
+
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return uint64_t(hi) << 32 | lo;
+#endif
+}
+
+static CpuFeatures detect() {
+    CpuFeatures f;
+    uint32_t r[4];
+    cpuid(0, 0, r);
+    uint32_t max_leaf = r[0];
+
+    cpuid(1, 0, r);
+    f.sse41 = r[2] >> 19 & 1;
+    bool osxsave = r[2] >> 27 & 1;
+    bool fma = r[2] >> 12 & 1;
+    if (!osxsave || max_leaf < 7)
+        return f;
+
+    uint64_t xcr0 = xgetbv0();
+    bool ymm = (xcr0 & 0x6) == 0x6;    // SSE and AVX state
+    bool zmm = (xcr0 & 0xe6) == 0xe6; // plus opmask and the upper ZMM registers
+
+    cpuid(7, 0, r);
+    f.avx2 = ymm && (r[1] >> 5 & 1);
+    f.fma = ymm && fma;
+    f.avx512f = zmm && (r[1] >> 16 & 1);
+    f.avx512dq = f.avx512f && (r[1] >> 17 & 1);
+    f.avx512bw = f.avx512f && (r[1] >> 30 & 1);
+    f.avx512vl = f.avx512f && (r[1] >> 31 & 1);
+    return f;
+}
+#else
+static CpuFeatures detect() { return {}; }
+#endif
+
+const CpuFeatures &cpu_features() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+const char *simd_level_to_string(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::scalar:
+        return "scalar";
+    case SimdLevel::sse41:
+        return "sse4.1";
+    case SimdLevel::avx2:
+        return "avx2";
+    case SimdLevel::avx512:
+        return "avx512";
+    };
+    return "unknown";
+}
+
+SimdLevel best_simd_level() {
+    auto &f = cpu_features();
+    if (f.avx2 && f.fma && f.avx512f && f.avx512dq && f.avx512vl)
+        return SimdLevel::avx512;
+    if (f.avx2 && f.fma)
+        return SimdLevel::avx2;
+    if (f.sse41)
+        return SimdLevel::sse41;
+    return SimdLevel::scalar;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+// x86 instruction set extensions usable on this machine, queried once. AVX flags also require
+// the OS to save the wider registers, so they can be trusted as is.
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512dq = false;
+    bool avx512vl = false;
+};
+
+const CpuFeatures &cpu_features();
+
+// Best kernel flavor to dispatch to, each level implies the ones below it.
+enum class SimdLevel {
+    scalar,
+    sse41,
+    avx2,   // with FMA
+    avx512, // F, DQ and VL, on top of AVX2
+};
+
+const char *simd_level_to_string(SimdLevel level);
+SimdLevel best_simd_level();
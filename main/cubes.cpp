@@ -0,0 +1,448 @@
+#pragma once
+
+#include "config_manager.h"
+#include "cull.h"
+#include "graphics.h"
+#include "jobs.h"
+#include "main.h"
+#include "module_registry.h"
+#include "settings.h"
+#include "opengl_helpers/gpu_heap.hpp"
+#include "opengl_helpers/indirect_draw.hpp"
+#include "opengl_helpers/program.hpp"
+#include "opengl_helpers/shader_manager.hpp"
+#include "opengl_helpers/stream_buffer.hpp"
+#include "opengl_helpers/vertex_layout.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace ig = ImGui;
+namespace l = spdlog;
+
+// What a visible cube turns into on the GPU, one per instance.
+struct CubeInstance {
+    glm::vec4 position_scale; // center.xyz, half extent
+    glm::vec4 rotation;       // unit quaternion, xyz + w
+};
+
+#define CUBE_INSTANCE_FIELDS(X)                                                                    \
+    X(position_scale, 0)                                                                           \
+    X(rotation, 1)
+
+MAKE_VERTEX_LAYOUT(CubeInstance, 1, CUBE_INSTANCE_FIELDS);
+
+// The unit cube as a real mesh, for the GPU culled path where every cube is its own indexed draw.
+struct CubeVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+#define CUBE_VERTEX_FIELDS(X)                                                                      \
+    X(position, 0)                                                                                 \
+    X(normal, 1)
+
+MAKE_VERTEX_LAYOUT(CubeVertex, 0, CUBE_VERTEX_FIELDS);
+
+enum class CubeFeatures : uint32_t {
+    // per cube data comes from a storage buffer indexed by the draw's object id
+    GpuCull = 1 << 0,
+};
+
+#define CUBE_FEATURES(X) X(CubeFeatures::GpuCull, "GPU_CULL")
+
+MAKE_SHADER_FEATURES(CubeFeatures, CUBE_FEATURES);
+
+struct CubeFieldStats {
+    size_t instances = 0;
+    size_t visible = 0;
+    double cull_ms = 0.0;   // frustum culling on the CPU
+    double upload_ms = 0.0; // copying the visible instances into the stream buffer
+    bool gpu = false;       // culled on the GPU, which leaves visible and the timings at 0
+};
+
+/**
+ * \brief A field of up to a million cubes seen from an orbiting camera. Bounds are culled against
+ * the frustum on every core with the SIMD kernels, then the survivors are copied into a stream
+ * buffer and drawn with one instanced call.
+ *
+ * With gpu_cull set the CPU does neither: GPUCulledDraw culls every cube in a compute shader and
+ * draws the survivors from a MeshHeap with one multi-draw-indirect call. Under the debug GL profile
+ * the first GPU cull after an upload is checked against the CPU kernels, which is how the path is
+ * validated headlessly, e.g. with LIBGL_ALWAYS_SOFTWARE=1 (Mesa llvmpipe) and
+ * --hidden --gl-profile=debug --bench=<frames>.
+ */
+class CubeField {
+  private:
+    // the mesh is constant, so it lives in the shader and the only vertex input is per instance
+    static constexpr const char *VERTEX_SHADER_SOURCE = R"(
+#version 450 core
+#ifdef GPU_CULL
+layout(location = 0) in vec3 aPosition; // unit cube corner
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in uint aObject;   // the draw's baseInstance, see GPUCulledDraw
+
+struct Cube {
+    vec4 positionScale;
+    vec4 rotation;
+};
+layout(std430, binding = 3) readonly buffer Cubes { Cube cubes[]; };
+#else
+layout(location = 0) in vec4 iPositionScale; // center.xyz, half extent
+layout(location = 1) in vec4 iRotation;      // unit quaternion
+#endif
+
+uniform mat4 uViewProjection;
+
+flat out vec3 vNormal;
+flat out vec3 vColor;
+
+// corner i has x, y and z in bits 0, 1 and 2
+const vec3 CORNERS[8] = vec3[8](vec3(-1, -1, -1), vec3(1, -1, -1), vec3(-1, 1, -1),
+                                vec3(1, 1, -1), vec3(-1, -1, 1), vec3(1, -1, 1), vec3(-1, 1, 1),
+                                vec3(1, 1, 1));
+// two counter-clockwise triangles per face, faces in the order of NORMALS
+const int INDICES[36] = int[36](0, 6, 2, 0, 4, 6, 1, 3, 7, 1, 7, 5, 0, 1, 5, 0, 5, 4,
+                                2, 7, 3, 2, 6, 7, 0, 3, 1, 0, 2, 3, 4, 5, 7, 4, 7, 6);
+const vec3 NORMALS[6] = vec3[6](vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, -1, 0), vec3(0, 1, 0),
+                                vec3(0, 0, -1), vec3(0, 0, 1));
+
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+#ifdef GPU_CULL
+    vec4 positionScale = cubes[aObject].positionScale;
+    vec4 rotation = cubes[aObject].rotation;
+    vec3 corner = aPosition;
+    vec3 normal = aNormal;
+#else
+    vec4 positionScale = iPositionScale;
+    vec4 rotation = iRotation;
+    vec3 corner = CORNERS[INDICES[gl_VertexID]];
+    vec3 normal = NORMALS[gl_VertexID / 6];
+#endif
+    vNormal = rotate(rotation, normal);
+    // from the position rather than gl_InstanceID, which changes as cubes are culled
+    vColor = 0.5 + 0.5 * cos(positionScale.xyz * 0.05 + vec3(0.0, 2.0, 4.0));
+    vec3 local = rotate(rotation, corner * positionScale.w);
+    gl_Position = uViewProjection * vec4(positionScale.xyz + local, 1.0);
+}
+)";
+
+    static constexpr const char *FRAGMENT_SHADER_SOURCE = R"(
+#version 450 core
+flat in vec3 vNormal;
+flat in vec3 vColor;
+layout(location = 0) out vec4 outColor;
+
+const vec3 LIGHT = normalize(vec3(0.4, 0.8, 0.3));
+
+void main() {
+    outColor = vec4(vColor * (0.25 + 0.75 * max(dot(vNormal, LIGHT), 0.0)), 1.0);
+}
+)";
+
+    // spheres per culling job, also the unit visible instances are gathered in
+    static constexpr size_t GRAIN = 16384;
+    static constexpr float SPACING = 4.0f; // average distance between neighbouring cubes
+    static constexpr float ORBIT_SPEED = 0.05f;
+    static constexpr GLuint CUBES_BINDING = 3; // storage buffer binding of Cubes in the shader
+
+    std::unique_ptr<GLProgram> program;
+    UniformHandle viewProjection;
+    std::shared_ptr<GLVertexArray> vao;
+    GLStreamBuffer<CubeInstance> instances;
+
+    // per cube, the bounds split by component for the culling kernels
+    std::vector<CubeInstance> cubes;
+    std::vector<float> x, y, z, radius;
+    float extent = 0.0f; // half the side of the volume the cubes are spread over
+
+    // per frame, chunk k compacts its visible indices to the start of its own range
+    std::vector<uint32_t> visible;
+    std::vector<size_t> chunk_counts, chunk_offsets;
+
+    // everything the GPU culled path needs, built the first time it is switched on
+    struct GpuPath {
+        std::unique_ptr<GLProgram> program;
+        UniformHandle viewProjection;
+        GPUCulledDraw draw;
+        MeshHeap<CubeVertex> meshes{24, 36};
+        MeshHeap<CubeVertex>::Handle cube;
+        GLVertexArray vao;
+        std::unique_ptr<GLBuffer<CubeInstance>> cubes; // every cube, indexed by object id
+        size_t uploaded = 0;    // cube count the buffers were last filled for
+        bool validated = false; // the last upload was checked against the CPU kernels
+    };
+    std::unique_ptr<GpuPath> gpu;
+    CubeFieldStats stats;
+
+    void populate(size_t count) {
+        extent = std::cbrt(static_cast<float>(count)) * SPACING * 0.5f;
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-extent, extent);
+        std::uniform_real_distribution<float> size(0.3f, 1.0f);
+        std::normal_distribution<float> gauss;
+
+        cubes.resize(count);
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        radius.resize(count);
+        visible.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec4 p(position(rng), position(rng), position(rng), size(rng));
+            // normalized 4D gaussians are uniformly distributed rotations
+            glm::vec4 q(gauss(rng), gauss(rng), gauss(rng), gauss(rng));
+            cubes[i] = {p, q / std::max(glm::length(q), 1e-6f)};
+            x[i] = p.x;
+            y[i] = p.y;
+            z[i] = p.z;
+            radius[i] = p.w * std::sqrt(3.0f);
+        }
+        l::info("cube field: {} cubes in a {:.0f} unit volume", count, extent * 2.0f);
+    }
+
+    static std::unique_ptr<GLProgram> make_program(bool gpu_cull, UniformHandle &vp) {
+        auto key = ShaderVariantKey<CubeFeatures>{}.with(CubeFeatures::GpuCull, gpu_cull);
+        auto vs = ShaderManager::get().getVariant("cubes_vertex", GL_VERTEX_SHADER,
+                                                  VERTEX_SHADER_SOURCE, key);
+        auto fs = ShaderManager::get().getShader("cubes_fragment", GL_FRAGMENT_SHADER,
+                                                 FRAGMENT_SHADER_SOURCE);
+        auto program = std::make_unique<GLProgram>(*vs, *fs);
+        vp = program->uniform("uViewProjection");
+        if (!vp.valid())
+            throw std::runtime_error("uViewProjection uniform not found");
+        return program;
+    }
+
+    // Four vertices per face so every face has its own normal, faces in the shader's NORMALS order.
+    static void build_cube_mesh(std::vector<CubeVertex> &vertices, std::vector<GLuint> &indices) {
+        const glm::vec2 quad[4] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (int face = 0; face < 6; ++face) {
+            int axis = face / 2;
+            float sign = face % 2 ? 1.0f : -1.0f;
+            glm::vec3 normal(0.0f);
+            normal[axis] = sign;
+            auto base = static_cast<GLuint>(vertices.size());
+            for (int k = 0; k < 4; ++k) {
+                // (axis + 1, axis + 2) spans the face counter-clockwise seen from +axis
+                auto uv = quad[sign > 0 ? k : 3 - k];
+                glm::vec3 position = normal;
+                position[(axis + 1) % 3] = uv.x;
+                position[(axis + 2) % 3] = uv.y;
+                vertices.push_back({position, normal});
+            }
+            for (GLuint i : {0u, 1u, 2u, 0u, 2u, 3u})
+                indices.push_back(base + i);
+        }
+    }
+
+    GpuPath &gpu_path() {
+        if (gpu)
+            return *gpu;
+        gpu = std::make_unique<GpuPath>();
+        gpu->program = make_program(true, gpu->viewProjection);
+        std::vector<CubeVertex> vertices;
+        std::vector<GLuint> indices;
+        build_cube_mesh(vertices, indices);
+        gpu->cube = gpu->meshes.add(vertices, indices);
+        applyVertexLayout(gpu->vao, makeVertexLayout<CubeVertex>());
+        gpu->meshes.bind(gpu->vao);
+        l::info("cube field: GPU culling {} the draw list",
+                gpu->draw.isCompacting() ? "compacts" : "zeroes culled entries in");
+        return *gpu;
+    }
+
+    void upload_gpu(GpuPath &g) {
+        auto range = g.meshes.range(g.cube);
+        std::vector<CullObject> objects(cubes.size());
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            objects[i] = {glm::vec4(x[i], y[i], z[i], radius[i]), range.indexCount,
+                          range.firstIndex, range.baseVertex};
+        }
+        g.draw.setObjects(objects);
+        g.cubes = std::make_unique<GLBuffer<CubeInstance>>();
+        g.cubes->store(cubes);
+        // the id buffer is replaced when the capacity grows
+        g.draw.bindObjectIds(g.vao, 2, 1);
+        g.uploaded = cubes.size();
+        g.validated = false;
+    }
+
+    // Reads the GPU result back once and compares it with the CPU kernels on the same frustum.
+    void validate_gpu(GpuPath &g, const Frustum &frustum) {
+        SphereBounds bounds{x.data(), y.data(), z.data(), radius.data()};
+        size_t cpu = cull_kernels().cull_spheres(bounds, 0, cubes.size(), frustum, visible.data());
+        size_t gpu_visible = g.draw.countVisible();
+        size_t diff = cpu > gpu_visible ? cpu - gpu_visible : gpu_visible - cpu;
+        // spheres touching a plane can land either way with a different rounding order
+        if (diff > cubes.size() / 10000)
+            l::error("cube field: GPU culling kept {} cubes, the CPU kernels {}", gpu_visible, cpu);
+        else
+            l::info("cube field: GPU culling validated, {} of {} cubes visible", gpu_visible,
+                    cubes.size());
+        g.validated = true;
+    }
+
+    void render_gpu(State &ctx, const glm::mat4 &vp, const Frustum &frustum) {
+        auto &g = gpu_path();
+        if (g.uploaded != cubes.size())
+            upload_gpu(g);
+
+        g.draw.cull(vp);
+        if (ctx.gl_profile == GLProfile::debug && !g.validated)
+            validate_gpu(g, frustum);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CUBES_BINDING, g.cubes->get());
+        g.vao.bind();
+        g.program->set(g.viewProjection, vp);
+        g.program->use();
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        g.draw.draw();
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+
+        // nothing comes back to the CPU, so there is no visible count or timing to report
+        stats = {};
+        stats.instances = cubes.size();
+        stats.gpu = true;
+    }
+
+  public:
+    static constexpr int MAX_CUBES = 1'000'000;
+
+    CubeField() : instances(1 << 16) {
+        program = make_program(false, viewProjection);
+        vao = VertexArrayCache::get().acquire<CubeInstance>();
+    }
+
+    void render(State &ctx, const cubes_config &cfg) {
+        auto count = static_cast<size_t>(std::clamp(cfg.count, 0, MAX_CUBES));
+        int w, h;
+        glfwGetFramebufferSize(ctx.w, &w, &h);
+        if (!cfg.enabled || count == 0 || w == 0 || h == 0) {
+            stats = {};
+            return;
+        }
+        if (count != cubes.size())
+            populate(count);
+
+        float angle = static_cast<float>(glfwGetTime()) * ORBIT_SPEED;
+        glm::vec3 eye(std::cos(angle) * extent, extent * 0.25f, std::sin(angle) * extent);
+        glm::mat4 vp = glm::perspective(glm::radians(60.0f), static_cast<float>(w) / h, 0.1f,
+                                        extent * 4.0f) *
+                       glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        auto frustum = extract_frustum(vp);
+        if (cfg.gpu_cull) {
+            render_gpu(ctx, vp, frustum);
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        auto &kernels = cull_kernels();
+        SphereBounds bounds{x.data(), y.data(), z.data(), radius.data()};
+        size_t chunks = (count + GRAIN - 1) / GRAIN;
+        chunk_counts.assign(chunks, 0);
+        chunk_offsets.resize(chunks);
+        JobSystem::get().parallel_for(count, GRAIN, [&](size_t begin, size_t end) {
+            chunk_counts[begin / GRAIN] =
+                kernels.cull_spheres(bounds, begin, end, frustum, visible.data() + begin);
+        });
+        std::exclusive_scan(chunk_counts.begin(), chunk_counts.end(), chunk_offsets.begin(),
+                            size_t(0));
+        size_t total = chunk_offsets.back() + chunk_counts.back();
+        auto culled = clock::now();
+
+        stats.instances = count;
+        stats.gpu = false;
+        stats.visible = total;
+        stats.cull_ms = std::chrono::duration<double, std::milli>(culled - start).count();
+        stats.upload_ms = 0.0;
+        if (total == 0)
+            return;
+
+        // the mapping is plain memory, workers can fill it while GL calls stay on this thread
+        auto region = instances.acquire(total);
+        CubeInstance *out = region.data.data();
+        JobSystem::get().parallel_for(count, GRAIN, [&](size_t begin, size_t) {
+            size_t k = begin / GRAIN;
+            const uint32_t *src = visible.data() + begin;
+            CubeInstance *dst = out + chunk_offsets[k];
+            for (size_t j = 0; j < chunk_counts[k]; ++j)
+                dst[j] = cubes[src[j]];
+        });
+        stats.upload_ms =
+            std::chrono::duration<double, std::milli>(clock::now() - culled).count();
+
+        vao->setVertexBuffer(instances.get(), 0, sizeof(CubeInstance),
+                             static_cast<GLuint>(region.first * sizeof(CubeInstance)));
+        vao->bind();
+        program->set(viewProjection, vp);
+        program->use();
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(total));
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        instances.release();
+    }
+
+    const CubeFieldStats &get_stats() const { return stats; }
+
+    CubeField(const CubeField &) = delete;
+    CubeField &operator=(const CubeField &) = delete;
+};
+
+void cubes_module(Registry &reg, State &ctx) {
+    auto cfg = mngr->getSection<cubes_config>("cubes");
+    if (!cfg)
+        return;
+    try {
+        auto field = std::make_shared<CubeField>();
+        // moves every frame, so never cached, and drawn after the background
+        reg.add_render_pass({
+            .draw = [field, cfg, &ctx]() { field->render(ctx, cfg->data); },
+            .order = 1,
+        });
+        // a tab of its own in the debug window, ImGui appends to a window and tab bar that were
+        // already begun this frame
+        reg.add_ui_panel([field, cfg]() {
+            ig::Begin("debug##Main", NULL, ImGuiWindowFlags_AlwaysAutoResize);
+            if (ig::BeginTabBar("debug")) {
+                if (ig::BeginTabItem("Cubes")) {
+                    ig::Checkbox("Draw cube field", &cfg->data.enabled);
+                    ig::SliderInt("Cubes", &cfg->data.count, 1000, CubeField::MAX_CUBES, "%d",
+                                  ImGuiSliderFlags_Logarithmic);
+                    ig::Checkbox("Cull on the GPU", &cfg->data.gpu_cull);
+                    auto &s = field->get_stats();
+                    if (s.gpu) {
+                        ig::Text("Instances: %zu, culled and drawn on the GPU", s.instances);
+                    } else {
+                        ig::Text("Instances: %zu, visible: %zu, culled: %zu", s.instances,
+                                 s.visible, s.instances - s.visible);
+                        ig::Text("Culling: %.3f ms (%s, %zu threads), upload: %.3f ms",
+                                 s.cull_ms, simd_level_to_string(cull_kernels().level),
+                                 JobSystem::get().worker_count() + 1, s.upload_ms);
+                    }
+                    ig::EndTabItem();
+                }
+                ig::EndTabBar();
+            }
+            ig::End();
+        });
+    } catch (const std::exception &e) {
+        l::error("Failed to create cube field: {}", e.what());
+    }
+}
+REGISTER_MODULE(cubes_module);
@@ -0,0 +1,30 @@
+#include "cull_impl.h"
+#include <algorithm>
+
+static size_t cull_spheres_scalar(const SphereBounds &s, size_t begin, size_t end,
+                                  const Frustum &frustum, uint32_t *out) {
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (sphere_visible(frustum, s.x[i], s.y[i], s.z[i], s.radius[i]))
+            out[n++] = static_cast<uint32_t>(i);
+    }
+    return n;
+}
+
+static const CullKernels &cull_kernels_scalar() {
+    static const CullKernels kernels{
+        .level = SimdLevel::scalar,
+        .cull_spheres = cull_spheres_scalar,
+    };
+    return kernels;
+}
+
+const CullKernels &cull_kernels(SimdLevel level) {
+    level = std::min(level, best_simd_level());
+#if CPU_X86
+    // a 4 wide flavor would mostly be movemask and compaction overhead, SSE4.1 takes the scalar one
+    if (level >= SimdLevel::avx2)
+        return cull_kernels_avx2();
+#endif
+    return cull_kernels_scalar();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "frustum.h"
+#include <cstddef>
+#include <cstdint>
+
+// Frustum culling over bounding spheres kept as one array per component, so the SIMD kernels
+// load the same component of 8 spheres at once.
+
+struct SphereBounds {
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *radius;
+};
+
+/**
+ * \brief One implementation of every culling kernel. `cull_spheres` writes the index of every
+ * sphere in [begin, end) that is at least partly inside `frustum` to `out`, in order, and returns
+ * how many it wrote. `out` needs room for end - begin indices, which lets callers split a range
+ * across threads and compact each chunk in place.
+ */
+struct CullKernels {
+    SimdLevel level;
+    size_t (*cull_spheres)(const SphereBounds &spheres, size_t begin, size_t end,
+                           const Frustum &frustum, uint32_t *out);
+};
+
+// Kernels for `level`, or the best this CPU runs when `level` isn't supported.
+const CullKernels &cull_kernels(SimdLevel level = best_simd_level());
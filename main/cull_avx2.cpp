@@ -0,0 +1,83 @@
+#include "cull_impl.h"
+#include <array>
+#include <bit>
+
+#if CPU_X86
+// Same rules as image_kernels_avx2.cpp: includes first, then AVX2 for the kernels only.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+
+// For each 8 bit visibility mask, the lanes that are set packed into 4 bit fields from the
+// bottom up. Shifting a broadcast of the entry by 0, 4, ... 28 gives the lane indices to store.
+static constexpr auto COMPACT_LUT = [] {
+    std::array<uint32_t, 256> lut{};
+    for (uint32_t mask = 0; mask < 256; ++mask) {
+        uint32_t packed = 0, n = 0;
+        for (uint32_t lane = 0; lane < 8; ++lane) {
+            if (mask & (1u << lane))
+                packed |= lane << (4 * n++);
+        }
+        lut[mask] = packed;
+    }
+    return lut;
+}();
+
+static size_t cull_spheres_avx2(const SphereBounds &s, size_t begin, size_t end,
+                                const Frustum &frustum, uint32_t *out) {
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm256_set1_ps(frustum[p].x);
+        py[p] = _mm256_set1_ps(frustum[p].y);
+        pz[p] = _mm256_set1_ps(frustum[p].z);
+        pw[p] = _mm256_set1_ps(frustum[p].w);
+    }
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i nibble = _mm256_set1_epi32(0xf);
+
+    size_t n = 0, i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(s.x + i);
+        __m256 y = _mm256_loadu_ps(s.y + i);
+        __m256 z = _mm256_loadu_ps(s.z + i);
+        __m256 r = _mm256_loadu_ps(s.radius + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 d = _mm256_fmadd_ps(pz[p], z, _mm256_add_ps(pw[p], r));
+            d = _mm256_fmadd_ps(px[p], x, _mm256_fmadd_ps(py[p], y, d));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        auto mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+        if (!mask)
+            continue;
+        __m256i lanes = _mm256_and_si256(
+            _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(COMPACT_LUT[mask])), shifts),
+            nibble);
+        // all 8 lanes are stored, n <= i - begin keeps the ones past the count inside the chunk
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + n),
+                            _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i))));
+        n += std::popcount(mask);
+    }
+    for (; i < end; ++i) {
+        if (sphere_visible(frustum, s.x[i], s.y[i], s.z[i], s.radius[i]))
+            out[n++] = static_cast<uint32_t>(i);
+    }
+    return n;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const CullKernels &cull_kernels_avx2() {
+    static const CullKernels kernels{
+        .level = SimdLevel::avx2,
+        .cull_spheres = cull_spheres_avx2,
+    };
+    return kernels;
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+// Shared by the cull*.cpp files, everything else goes through cull.h.
+
+#include "cull.h"
+
+inline bool sphere_visible(const Frustum &frustum, float x, float y, float z, float r) {
+    for (auto &p : frustum) {
+        if (p.x * x + p.y * y + p.z * z + p.w + r < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+#if CPU_X86
+const CullKernels &cull_kernels_avx2();
+#endif
@@ -1,11 +1,27 @@
 #pragma once
 
+#include "benchmark.h"
 #include "config_manager.h"
+#include "dynamic_resolution.h"
+#include "entities.h"
 #include "graphics.h"
+#include "image_kernels.h"
+#include "jobs.h"
 #include "konfig/konfig.h"
 #include "main.h"
+#include "math_kernels.h"
 #include "module_registry.h"
+#include "post_process.h"
+#include "render_passes.h"
+#include "opengl_helpers/quad_batch.hpp"
+#include "opengl_helpers/shader_manager.hpp"
+#include "opengl_helpers/texture_manager.hpp"
+#include "opengl_helpers/texture_upload.hpp"
+#include "settings.h"
 #include "theme.h"
+#include "transforms.h"
+#include <algorithm>
+#include <array>
 #include <spdlog/spdlog.h>
 
 namespace l = spdlog;
@@ -21,10 +37,21 @@ struct test_config {
 
 MAKE_SECTION(test_config, TEST_FIELDS);
 
+static constexpr double SCALE_MIN = 0.25, SCALE_MAX = 1.0;
+
 void debug_window_module(Registry &reg, State &ctx) {
     auto cfg = mngr->addSection<test_config>("test");
+    auto frame = mngr->getSection<frame_config>("frame");
+    auto textures = mngr->getSection<texture_config>("textures");
+    auto resolution = mngr->getSection<resolution_config>("resolution");
+    auto post = mngr->getSection<post_config>("post");
+    auto sprites = mngr->getSection<sprites_config>("sprites");
+
+    auto bench_results = std::make_shared<std::vector<BenchResult>>();
+    auto bench_filter = std::make_shared<std::array<char, 64>>();
 
-    reg.add_ui_panel([&reg, &ctx, cfg]() {
+    reg.add_ui_panel([&reg, &ctx, cfg, frame, textures, resolution, post, sprites, bench_results,
+                      bench_filter]() {
         ig::Begin("debug##Main", NULL, ImGuiWindowFlags_AlwaysAutoResize);
 
         if (ig::BeginTabBar("debug")) {
@@ -34,6 +61,165 @@ void debug_window_module(Registry &reg, State &ctx) {
                 }
                 ig::SameLine();
                 ig::Checkbox("Display Debug Info", &ctx.display_debug);
+
+                auto &shader_stats = ShaderManager::get().getStats();
+                ig::Text("Shader variants: %zu, compile total: %.2f ms", shader_stats.variants,
+                         shader_stats.totalCompileMs);
+                if (shader_stats.variants > 0)
+                    ig::Text("Slowest: %s (%.2f ms)", shader_stats.slowest.c_str(),
+                             shader_stats.slowestCompileMs);
+                ig::EndTabItem();
+            }
+
+            if (ig::BeginTabItem("Performance")) {
+                if (frame) {
+                    ig::SliderInt("Frames in flight", &frame->data.frames_in_flight, 1, 3);
+                    ig::Checkbox("Just-in-time input", &frame->data.jit_input);
+                }
+                ig::Text("Frame wait: %.3f ms", ctx.frame_wait_ms);
+                if (frame)
+                    ig::Checkbox("Blit last frame on refresh", &frame->data.blit_refresh);
+                ig::Text("Refreshes: %zu coalesced, %zu rendered, %zu blitted",
+                         ctx.refreshes.coalesced, ctx.refreshes.rendered, ctx.refreshes.blitted);
+
+                ig::Separator();
+                if (frame)
+                    ig::Checkbox("Cache static passes", &frame->data.cache_passes);
+                if (ctx.passes) {
+                    auto &passes = ctx.passes->get_stats();
+                    ig::Text("Passes: %zu drawn of %zu, %zu cacheable, %s", passes.drawn,
+                             passes.passes, passes.cached, passes.replayed ? "replayed" : "drawn");
+                    ig::Text("Pass GPU time: %.3f ms, rebuilds: %zu, clear %s", passes.gpu_ms,
+                             passes.rebuilds, passes.clear_elided ? "elided" : "issued");
+                }
+                auto &targets = RenderTargetPool::get().getStats();
+                ig::Text("Render targets: %zu (%zu in use), %.2f MiB, peak %.2f MiB",
+                         targets.targets, targets.inUse, targets.bytes / (1024.0 * 1024.0),
+                         targets.peakBytes / (1024.0 * 1024.0));
+                ig::Text("Unused in held targets: %.2f MiB, created: %zu%s",
+                         targets.slackBytes / (1024.0 * 1024.0), targets.created,
+                         targets.resizing ? ", resizing" : "");
+
+                ig::Separator();
+                if (resolution) {
+                    auto &r = resolution->data;
+                    ig::Checkbox("Dynamic resolution", &r.dynamic);
+                    if (ig::InputDouble("Target GPU time (ms)", &r.target_ms, 0.5, 2.0, "%.1f"))
+                        r.target_ms = std::max(DynamicResolution::MIN_TARGET_MS, r.target_ms);
+                    ig::SliderScalar("Min scale", ImGuiDataType_Double, &r.min_scale, &SCALE_MIN,
+                                     &SCALE_MAX, "%.2f");
+                    ig::SliderScalar("Max scale", ImGuiDataType_Double, &r.max_scale, &SCALE_MIN,
+                                     &SCALE_MAX, "%.2f");
+                }
+                if (ctx.resolution) {
+                    auto &res = ctx.resolution->get_stats();
+                    ig::Text("Scene: %dx%d at %.0f%%, %.3f ms, %zu changes", res.width, res.height,
+                             res.scale * 100.0, res.gpu_ms, res.changes);
+                }
+
+                ig::Separator();
+                if (frame)
+                    ig::SliderInt("Upload budget (KiB)", &frame->data.upload_budget_kb, 256, 65536);
+                auto &uploads = TextureUploadQueue::get().getStats();
+                ig::Text("Texture uploads: %zu pending, %zu issued", uploads.pending,
+                         uploads.uploaded);
+                ig::Text("Uploaded last frame: %.1f KiB, staging in use: %.1f KiB",
+                         uploads.bytesLastFrame / 1024.0, uploads.ringInUse / 1024.0);
+
+                ig::Separator();
+                if (textures)
+                    ig::SliderInt("VRAM budget (MiB)", &textures->data.vram_budget_mb, 16, 4096);
+                auto &tex = TextureManager::get().getStats();
+                ig::Text("Textures: %zu (%zu unused), %.2f MiB, %zu samplers", tex.textures,
+                         tex.unused, tex.bytes / (1024.0 * 1024.0), tex.samplers);
+                ig::Text("Loads: %zu, cache hits: %zu, evictions: %zu, decoding: %zu", tex.loads,
+                         tex.hits, tex.evictions, tex.decoding);
+                ig::Text("Decode workers: %zu, image kernels: %s, math kernels: %s",
+                         JobSystem::get().worker_count(),
+                         simd_level_to_string(image_kernels().level),
+                         simd_level_to_string(math_kernels().level));
+
+                if (ctx.transforms) {
+                    auto &t = ctx.transforms->get_stats();
+                    ig::Separator();
+                    ig::Text("Transforms: %zu nodes in %zu levels, %zu rebuilds", t.nodes,
+                             t.levels, t.rebuilds);
+                    ig::Text("Updated last frame: %zu in %.3f ms (%s)", t.updated, t.update_ms,
+                             simd_level_to_string(transform_kernels().level));
+                }
+                if (ctx.entities) {
+                    auto &e = ctx.entities->get_stats();
+                    ig::Text("Entities: %zu in %zu archetypes, %zu changes in %.3f ms",
+                             e.entities, e.archetypes, e.applied, e.flush_ms);
+                }
+                ig::EndTabItem();
+            }
+
+            if (ig::BeginTabItem("Post")) {
+                if (post) {
+                    auto &p = post->data;
+                    ig::Checkbox("Fuse pointwise effects", &p.fuse);
+                    ig::Checkbox("Bloom", &p.bloom);
+                    ig::InputDouble("Bloom threshold", &p.bloom_threshold, 0.05, 0.25, "%.2f");
+                    ig::InputDouble("Bloom intensity", &p.bloom_intensity, 0.05, 0.25, "%.2f");
+                    ig::Checkbox("Blur", &p.blur);
+                    ig::SliderInt("Blur radius", &p.blur_radius, 1, 32);
+                    ig::Checkbox("Tonemap", &p.tonemap);
+                    ig::InputDouble("Exposure", &p.exposure, 0.1, 0.5, "%.2f");
+                    ig::Checkbox("Color grade", &p.grade);
+                    ig::InputDouble("Saturation", &p.saturation, 0.05, 0.25, "%.2f");
+                    ig::InputDouble("Contrast", &p.contrast, 0.05, 0.25, "%.2f");
+                }
+                if (ctx.post) {
+                    auto &stats = ctx.post->get_stats();
+                    ig::Separator();
+                    ig::Text("Effects: %zu in %zu dispatches, %zu fused", stats.effects,
+                             stats.dispatches, stats.fused);
+                    for (auto &t : stats.timings)
+                        ig::Text("%s: %.3f ms", t.name.c_str(), t.gpu_ms);
+                }
+                ig::EndTabItem();
+            }
+
+            if (ig::BeginTabItem("Sprites")) {
+                if (sprites) {
+                    ig::Checkbox("Draw sprites", &sprites->data.enabled);
+                    ig::SliderInt("Sprites", &sprites->data.count, 100, 1000000, "%d",
+                                  ImGuiSliderFlags_Logarithmic);
+                }
+                if (ctx.quads) {
+                    auto &q = ctx.quads->getStats();
+                    ig::Text("Quads: %zu in %zu draws", q.quads, q.batches);
+                }
+                ig::EndTabItem();
+            }
+
+            if (ig::BeginTabItem("Benchmarks")) {
+                // runs on the render thread, the window stalls until they are done
+                if (ig::Button("Run"))
+                    *bench_results = run_benchmarks(bench_filter->data());
+                ig::SameLine();
+                ig::InputText("Filter", bench_filter->data(), bench_filter->size());
+                if (!bench_results->empty() && ig::BeginTable("bench", 4)) {
+                    ig::TableSetupColumn("Name");
+                    ig::TableSetupColumn("Iterations");
+                    ig::TableSetupColumn("us/iter");
+                    ig::TableSetupColumn("MB/s");
+                    ig::TableHeadersRow();
+                    for (auto &r : *bench_results) {
+                        ig::TableNextRow();
+                        ig::TableNextColumn();
+                        ig::TextUnformatted(r.name.c_str());
+                        ig::TableNextColumn();
+                        ig::Text("%zu", r.iterations);
+                        ig::TableNextColumn();
+                        ig::Text("%.1f", r.ns_per_iter / 1000.0);
+                        ig::TableNextColumn();
+                        if (r.mb_per_s > 0)
+                            ig::Text("%.1f", r.mb_per_s);
+                    }
+                    ig::EndTable();
+                }
                 ig::EndTabItem();
             }
 
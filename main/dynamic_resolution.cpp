@@ -0,0 +1,81 @@
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::adjust(const resolution_config &cfg) {
+    double lo = std::clamp(cfg.min_scale, STEP, 1.0);
+    double hi = std::clamp(cfg.max_scale, lo, 1.0);
+    double scale = std::clamp(stats.scale, lo, hi);
+    // straight from the config file or the debug window
+    double target_ms = std::max(MIN_TARGET_MS, cfg.target_ms);
+
+    double ms = timer.ms();
+    if (cooldown > 0) {
+        cooldown--;
+    } else if (ms > 0.0) {
+        stats.gpu_ms = stats.gpu_ms == 0.0 ? ms : stats.gpu_ms + (ms - stats.gpu_ms) * SMOOTHING;
+        if (stats.gpu_ms > target_ms) {
+            // GPU time goes roughly with pixel count, so with the square of the scale
+            double fit = scale * std::sqrt(target_ms / stats.gpu_ms);
+            scale = std::min(std::floor(fit / STEP) * STEP, scale - STEP);
+        } else if (stats.gpu_ms < target_ms * HEADROOM) {
+            scale += STEP;
+        }
+        scale = std::clamp(std::round(scale / STEP) * STEP, lo, hi);
+    }
+    // e.g. NaN scale limits from the config, begin() would turn that into a garbage size
+    if (!std::isfinite(scale))
+        scale = stats.scale;
+
+    if (scale != stats.scale) {
+        stats.scale = scale;
+        stats.gpu_ms = 0.0;
+        stats.changes++;
+        cooldown = COOLDOWN_FRAMES;
+    }
+}
+
+SceneTarget DynamicResolution::begin(int display_w, int display_h, const resolution_config &cfg,
+                                     GLenum offscreen_format) {
+    this->display_w = display_w;
+    this->display_h = display_h;
+    timing = cfg.dynamic;
+    if (cfg.dynamic) {
+        adjust(cfg);
+        timer.begin();
+    } else {
+        stats.scale = 1.0;
+        stats.gpu_ms = 0.0;
+        cooldown = COOLDOWN_FRAMES;
+    }
+
+    int w = std::max(1, static_cast<int>(std::lround(display_w * stats.scale)));
+    int h = std::max(1, static_cast<int>(std::lround(display_h * stats.scale)));
+    // a minimized window has nothing to scale
+    if (display_w == 0 || display_h == 0 ||
+        (!offscreen_format && w == display_w && h == display_h)) {
+        target.reset();
+        stats.width = display_w;
+        stats.height = display_h;
+        return {nullptr, 0, display_w, display_h};
+    }
+
+    stats.width = w;
+    stats.height = h;
+    RenderTargetPool::get().fit(target, {w, h, offscreen_format ? offscreen_format : GL_RGBA8});
+    target->bind();
+    return {target.get(), target->get(), w, h};
+}
+
+void DynamicResolution::end(const RenderTarget *output) {
+    if (!output)
+        output = target.get();
+    if (output) {
+        glBlitNamedFramebuffer(output->get(), 0, 0, 0, output->width(), output->height(), 0, 0,
+                               display_w, display_h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, display_w, display_h);
+    }
+    if (timing)
+        timer.end();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "opengl_helpers/gpu_timer.hpp"
+#include "opengl_helpers/render_target.hpp"
+#include "settings.h"
+#include <memory>
+
+// Framebuffer the scene draws into for a frame, already bound with its viewport set.
+struct SceneTarget {
+    const RenderTarget *target = nullptr; // null when drawing straight into the window
+    GLuint fbo = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct DynamicResolutionStats {
+    double scale = 1.0;
+    int width = 0;
+    int height = 0;
+    double gpu_ms = 0.0; // smoothed scene time the scale is chosen from
+    size_t changes = 0;  // over the whole run
+};
+
+/**
+ * \brief Draws the scene into an offscreen target whose size follows its measured GPU time, and
+ * upscales it to the window afterwards. The scale drops as soon as the scene runs over budget and
+ * creeps back up one step at a time while there is headroom. At full scale the scene draws
+ * straight into the window, so enabling it costs nothing when the GPU keeps up.
+ */
+class DynamicResolution {
+  private:
+    // quantizing keeps the number of distinct target sizes in the pool small
+    static constexpr double STEP = 0.05;
+    // grow only when the scene would still fit after one more step
+    static constexpr double HEADROOM = 0.8;
+    static constexpr double SMOOTHING = 0.1;
+    // timings lag by the timer's latency, skip those still measuring the old scale
+    static constexpr int COOLDOWN_FRAMES = 8;
+
+    std::shared_ptr<RenderTarget> target;
+    GpuTimer<> timer;
+    bool timing = false;
+    int cooldown = 0;
+    int display_w = 0, display_h = 0;
+    DynamicResolutionStats stats;
+
+    void adjust(const resolution_config &cfg);
+
+  public:
+    // lowest target_ms that is honoured, zero or negative budgets would collapse the scale
+    static constexpr double MIN_TARGET_MS = 0.1;
+
+    /**
+     * \brief Binds the framebuffer the scene should draw into for a `display_w` x `display_h`
+     * window. A nonzero `offscreen_format` asks for an offscreen target in that format even at
+     * full scale, for stages that read the scene back.
+     */
+    SceneTarget begin(int display_w, int display_h, const resolution_config &cfg,
+                      GLenum offscreen_format = 0);
+    // Upscales `output`, or the scene target if null, into the default framebuffer and leaves it
+    // bound at the window size.
+    void end(const RenderTarget *output = nullptr);
+    const DynamicResolutionStats &get_stats() const { return stats; }
+};
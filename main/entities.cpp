@@ -0,0 +1,162 @@
+#include "entities.h"
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+struct ComponentInfo {
+    size_t size;
+    const char *name;
+};
+
+static std::mutex &components_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+static std::vector<ComponentInfo> &components() {
+    static std::vector<ComponentInfo> list;
+    return list;
+}
+
+ComponentId register_component(size_t size, const char *name) {
+    std::lock_guard lock(components_mutex());
+    auto &list = components();
+    if (list.size() == MAX_COMPONENTS)
+        throw std::runtime_error(std::string("Too many component types, can't add ") + name);
+    list.push_back({size, name});
+    return static_cast<ComponentId>(list.size() - 1);
+}
+
+size_t component_size(ComponentId id) {
+    std::lock_guard lock(components_mutex());
+    return components()[id].size;
+}
+
+EntityStore::EntityStore() {
+    // entities without components live here
+    archetype_for(0);
+}
+
+EntityStore::Archetype &EntityStore::archetype_for(ComponentMask mask) {
+    auto it = archetype_of.find(mask);
+    if (it != archetype_of.end())
+        return *archetypes[it->second];
+
+    auto a = std::make_unique<Archetype>();
+    a->mask = mask;
+    a->column_of.fill(-1);
+    for (ComponentMask bits = mask; bits; bits &= bits - 1) {
+        auto id = static_cast<ComponentId>(std::countr_zero(bits));
+        a->column_of[id] = static_cast<int8_t>(a->columns.size());
+        a->columns.push_back({component_size(id), {}});
+    }
+    archetype_of.emplace(mask, static_cast<uint32_t>(archetypes.size()));
+    archetypes.push_back(std::move(a));
+    return *archetypes.back();
+}
+
+uint32_t EntityStore::append_row(Archetype &a, Entity e) {
+    auto row = static_cast<uint32_t>(a.entities.size());
+    a.entities.push_back(e);
+    for (auto &c : a.columns)
+        c.data.resize(c.data.size() + c.size);
+    auto index = archetype_of.at(a.mask);
+    locations[e.index] = {index, row};
+    return row;
+}
+
+void EntityStore::remove_row(Archetype &a, uint32_t row) {
+    // the last row fills the gap, so columns stay dense
+    auto last = static_cast<uint32_t>(a.entities.size() - 1);
+    if (row != last) {
+        for (auto &c : a.columns)
+            std::memcpy(c.data.data() + row * c.size, c.data.data() + last * c.size, c.size);
+        a.entities[row] = a.entities[last];
+        locations[a.entities[row].index].row = row;
+    }
+    a.entities.pop_back();
+    for (auto &c : a.columns)
+        c.data.resize(c.data.size() - c.size);
+}
+
+void EntityStore::move_row(Entity e, Archetype &to) {
+    auto from_loc = locations[e.index];
+    auto &from = *archetypes[from_loc.archetype];
+    uint32_t row = append_row(to, e);
+    for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+        if (from.column_of[i] < 0 || to.column_of[i] < 0)
+            continue;
+        auto &src = from.columns[from.column_of[i]];
+        auto &dst = to.columns[to.column_of[i]];
+        std::memcpy(dst.data.data() + row * dst.size, src.data.data() + from_loc.row * src.size,
+                    src.size);
+    }
+    remove_row(from, from_loc.row);
+}
+
+void EntityStore::write_values(Archetype &a, uint32_t row, size_t offset, ComponentMask mask) {
+    for (int n = std::popcount(mask); n > 0; --n) {
+        ComponentId id;
+        std::memcpy(&id, payload.data() + offset, sizeof(id));
+        auto &c = a.columns[a.column_of[id]];
+        std::memcpy(c.data.data() + row * c.size, payload.data() + offset + sizeof(id), c.size);
+        offset += sizeof(id) + c.size;
+    }
+}
+
+void EntityStore::apply(const Command &c) {
+    bool created = c.op == Op::create;
+    if (created ? locations[c.entity.index].archetype != NONE : !alive(c.entity))
+        return;
+
+    switch (c.op) {
+    case Op::create: {
+        auto &a = archetype_for(c.mask);
+        write_values(a, append_row(a, c.entity), c.payload, c.mask);
+        break;
+    }
+    case Op::add: {
+        auto mask = archetypes[locations[c.entity.index].archetype]->mask;
+        auto &a = archetype_for(mask | c.mask);
+        if ((mask | c.mask) != mask)
+            move_row(c.entity, a);
+        write_values(a, locations[c.entity.index].row, c.payload, c.mask);
+        break;
+    }
+    case Op::remove: {
+        auto mask = archetypes[locations[c.entity.index].archetype]->mask;
+        if (mask & c.mask)
+            move_row(c.entity, archetype_for(mask & ~c.mask));
+        break;
+    }
+    case Op::destroy: {
+        auto loc = locations[c.entity.index];
+        remove_row(*archetypes[loc.archetype], loc.row);
+        locations[c.entity.index] = {};
+        generations[c.entity.index]++;
+        free_indices.push_back(c.entity.index);
+        break;
+    }
+    }
+}
+
+void EntityStore::flush() {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard lock(commands_mutex);
+    generations.resize(reserved, 0);
+    locations.resize(reserved);
+    for (auto &c : commands)
+        apply(c);
+
+    stats.applied = commands.size();
+    commands.clear();
+    payload.clear();
+    stats.entities = 0;
+    for (auto &a : archetypes)
+        stats.entities += a->entities.size();
+    stats.archetypes = archetypes.size();
+    stats.flush_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+}
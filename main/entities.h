@@ -0,0 +1,255 @@
+#pragma once
+
+#include "jobs.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// Generational handle, so one kept past its entity's destruction doesn't match a new entity that
+// reuses the index.
+struct Entity {
+    uint32_t index = ~0u;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity &) const = default;
+};
+
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+constexpr size_t MAX_COMPONENTS = 64;
+
+// Ids are handed out process wide on first use, so they survive module reloads.
+ComponentId register_component(size_t size, const char *name);
+size_t component_size(ComponentId id);
+
+template <typename T> ComponentId component_id() {
+    if constexpr (std::is_const_v<T>) {
+        // queries can ask for const T to only read it
+        return component_id<std::remove_const_t<T>>();
+    } else {
+        // rows are moved between archetypes with memcpy
+        static_assert(std::is_trivially_copyable_v<T>, "components have to be trivially copyable");
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "component is overaligned");
+        static const ComponentId id = register_component(sizeof(T), typeid(T).name());
+        return id;
+    }
+}
+
+template <typename... Ts> ComponentMask component_mask() {
+    return ((ComponentMask(1) << component_id<Ts>()) | ... | ComponentMask(0));
+}
+
+struct EntityStoreStats {
+    size_t entities = 0;
+    size_t archetypes = 0;
+    size_t applied = 0; // structural changes applied by the last flush
+    double flush_ms = 0.0;
+};
+
+/**
+ * \brief Archetype based entity/component store. Entities with the same set of components share
+ * an archetype, which keeps one contiguous column per component, so a query walks plain arrays.
+ * Queries hand out chunks of up to CHUNK rows, either on the calling thread or spread over the
+ * job system.
+ *
+ * Creating and destroying entities and adding or removing components only queue a command, which
+ * is safe from any thread, including inside a parallel query. flush() applies them at the frame
+ * boundary, so rows never move while something iterates. Component values can be written in
+ * place at any time.
+ */
+class EntityStore {
+  public:
+    static constexpr size_t CHUNK = 1024;
+    static constexpr uint32_t NONE = ~0u;
+
+  private:
+    struct Column {
+        size_t size; // bytes per component
+        std::vector<std::byte> data;
+    };
+
+    struct Archetype {
+        ComponentMask mask = 0;
+        std::array<int8_t, MAX_COMPONENTS> column_of; // -1 where the component isn't present
+        std::vector<Column> columns;
+        std::vector<Entity> entities;
+    };
+
+    struct Location {
+        uint32_t archetype = NONE; // NONE until the entity's create has been flushed
+        uint32_t row = 0;
+    };
+
+    enum class Op : uint8_t {
+        create,
+        add,
+        remove,
+        destroy,
+    };
+
+    // Values follow in `payload` as a ComponentId and the component's bytes, one per mask bit.
+    struct Command {
+        Op op;
+        Entity entity;
+        ComponentMask mask;
+        size_t payload;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, uint32_t> archetype_of;
+    std::vector<uint32_t> generations;
+    std::vector<Location> locations;
+    std::vector<uint32_t> free_indices;
+    uint32_t reserved = 0; // indices handed out, the tables catch up at flush()
+
+    std::mutex commands_mutex;
+    std::vector<Command> commands;
+    std::vector<std::byte> payload;
+    EntityStoreStats stats;
+
+    struct ChunkRef {
+        Archetype *archetype;
+        size_t begin, end;
+    };
+
+    Archetype &archetype_for(ComponentMask mask);
+    uint32_t append_row(Archetype &a, Entity e);
+    void remove_row(Archetype &a, uint32_t row);
+    void move_row(Entity e, Archetype &to);
+    void write_values(Archetype &a, uint32_t row, size_t offset, ComponentMask mask);
+    void apply(const Command &c);
+
+    template <typename T> static T *column(Archetype &a) {
+        return reinterpret_cast<T *>(a.columns[a.column_of[component_id<T>()]].data.data());
+    }
+
+    template <typename T> void push_value(const T &value) {
+        ComponentId id = component_id<T>();
+        size_t at = payload.size();
+        payload.resize(at + sizeof(id) + sizeof(T));
+        std::memcpy(payload.data() + at, &id, sizeof(id));
+        std::memcpy(payload.data() + at + sizeof(id), &value, sizeof(T));
+    }
+
+    template <typename... Ts> std::vector<ChunkRef> chunks() {
+        ComponentMask mask = component_mask<Ts...>();
+        std::vector<ChunkRef> out;
+        for (auto &a : archetypes) {
+            if ((a->mask & mask) != mask)
+                continue;
+            for (size_t begin = 0; begin < a->entities.size(); begin += CHUNK)
+                out.push_back({a.get(), begin, std::min(a->entities.size(), begin + CHUNK)});
+        }
+        return out;
+    }
+
+    template <typename... Ts, typename F> static void call(const ChunkRef &c, F &fn) {
+        fn(c.end - c.begin, c.archetype->entities.data() + c.begin,
+           (column<Ts>(*c.archetype) + c.begin)...);
+    }
+
+  public:
+    EntityStore();
+
+    /**
+     * \brief Reserves an entity that gets `values` as its components at the next flush(). The
+     * handle can be used in further commands right away.
+     */
+    template <typename... Ts> Entity create(const Ts &...values) {
+        std::lock_guard lock(commands_mutex);
+        // only reads the tables, queries on other threads may be looking at them
+        Entity e{0, 0};
+        if (!free_indices.empty()) {
+            e.index = free_indices.back();
+            e.generation = generations[e.index];
+            free_indices.pop_back();
+        } else {
+            e.index = reserved++;
+        }
+        commands.push_back({Op::create, e, component_mask<Ts...>(), payload.size()});
+        (push_value(values), ...);
+        return e;
+    }
+
+    // Adds `value`, or overwrites it if the entity already has a T, at the next flush().
+    template <typename T> void add(Entity e, const T &value) {
+        std::lock_guard lock(commands_mutex);
+        commands.push_back({Op::add, e, component_mask<T>(), payload.size()});
+        push_value(value);
+    }
+
+    template <typename T> void remove(Entity e) {
+        std::lock_guard lock(commands_mutex);
+        commands.push_back({Op::remove, e, component_mask<T>(), 0});
+    }
+
+    void destroy(Entity e) {
+        std::lock_guard lock(commands_mutex);
+        commands.push_back({Op::destroy, e, 0, 0});
+    }
+
+    // Applies the queued commands in the order they were made. Main calls it once per frame.
+    void flush();
+
+    bool alive(Entity e) const {
+        return e.index < generations.size() && generations[e.index] == e.generation &&
+               locations[e.index].archetype != NONE;
+    }
+
+    // The entity's T, nullptr if it is dead or has none. Valid until the next flush().
+    template <typename T> T *get(Entity e) {
+        if (!alive(e))
+            return nullptr;
+        auto &loc = locations[e.index];
+        auto &a = *archetypes[loc.archetype];
+        if (a.column_of[component_id<T>()] < 0)
+            return nullptr;
+        return column<T>(a) + loc.row;
+    }
+
+    /**
+     * \brief Calls fn(count, entities, Ts *...) on the calling thread for every chunk of the
+     * entities that have all of Ts. The arrays hold `count` rows.
+     */
+    template <typename... Ts, typename F> void each_chunk(F &&fn) {
+        for (auto &c : chunks<Ts...>())
+            call<Ts...>(c, fn);
+    }
+
+    // Like each_chunk(), with chunks spread over the job system. `fn` must not throw.
+    template <typename... Ts, typename F> void par_each_chunk(F &&fn) {
+        auto list = chunks<Ts...>();
+        JobSystem::get().parallel_for(list.size(), 1, [&list, &fn](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                call<Ts...>(list[i], fn);
+        });
+    }
+
+    // fn(entity, Ts &...) for every entity that has all of Ts.
+    template <typename... Ts, typename F> void each(F &&fn) {
+        each_chunk<Ts...>([&fn](size_t count, const Entity *entities, Ts *...columns) {
+            for (size_t i = 0; i < count; ++i)
+                fn(entities[i], columns[i]...);
+        });
+    }
+
+    template <typename... Ts, typename F> void par_each(F &&fn) {
+        par_each_chunk<Ts...>([&fn](size_t count, const Entity *entities, Ts *...columns) {
+            for (size_t i = 0; i < count; ++i)
+                fn(entities[i], columns[i]...);
+        });
+    }
+
+    const EntityStoreStats &get_stats() const { return stats; }
+
+    EntityStore(const EntityStore &) = delete;
+    EntityStore &operator=(const EntityStore &) = delete;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "graphics.h"
+#include <array>
+
+using Frustum = std::array<glm::vec4, 6>;
+
+/**
+ * \brief Extracts the six clip planes (left, right, bottom, top, near, far) from a view-projection
+ * matrix. Planes are normalized and point inwards, so a sphere is outside when
+ * dot(plane.xyz, center) + plane.w < -radius for any of them.
+ */
+inline Frustum extract_frustum(const glm::mat4 &m) {
+    auto row = [&m](int r) { return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]); };
+    Frustum planes = {row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                      row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+    for (auto &p : planes)
+        p /= glm::length(glm::vec3(p));
+    return planes;
+}
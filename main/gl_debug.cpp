@@ -0,0 +1,104 @@
+#include "gl_debug.h"
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+
+namespace l = spdlog;
+
+static GLDebugStats stats;
+static std::unordered_map<uint64_t, uint32_t> seen; // (source, type, id) -> repeat count
+
+std::string gl_profile_to_string(GLProfile p) {
+    switch (p) {
+    case GLProfile::debug:
+        return "debug";
+    case GLProfile::release:
+        return "release";
+    };
+    return "unknown";
+}
+
+static const char *source_to_string(GLenum source) {
+    switch (source) {
+    case GL_DEBUG_SOURCE_API:
+        return "api";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+        return "window system";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER:
+        return "shader compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY:
+        return "third party";
+    case GL_DEBUG_SOURCE_APPLICATION:
+        return "application";
+    default:
+        return "other";
+    }
+}
+
+static const char *type_to_string(GLenum type) {
+    switch (type) {
+    case GL_DEBUG_TYPE_ERROR:
+        return "error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+        return "deprecated";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+        return "undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY:
+        return "portability";
+    case GL_DEBUG_TYPE_PERFORMANCE:
+        return "performance";
+    case GL_DEBUG_TYPE_MARKER:
+        return "marker";
+    default:
+        return "other";
+    }
+}
+
+static void GLAD_API_PTR debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                        GLsizei length, const GLchar *message, const void *) {
+    stats.total_messages++;
+    if (type == GL_DEBUG_TYPE_PERFORMANCE)
+        stats.perf_this_frame++;
+
+    // drivers tend to repeat the same message every frame, only the first one gets logged
+    uint64_t key = static_cast<uint64_t>(source) << 48 ^ static_cast<uint64_t>(type) << 32 ^ id;
+    if (seen[key]++ > 0)
+        return;
+    stats.unique_messages = seen.size();
+
+    auto level = l::level::debug;
+    switch (severity) {
+    case GL_DEBUG_SEVERITY_HIGH:
+        level = l::level::err;
+        break;
+    case GL_DEBUG_SEVERITY_MEDIUM:
+        level = l::level::warn;
+        break;
+    case GL_DEBUG_SEVERITY_LOW:
+        level = l::level::info;
+        break;
+    }
+    l::log(level, "GL [{}/{}] #{}: {}", source_to_string(source), type_to_string(type), id,
+           std::string_view(message, length));
+}
+
+bool install_gl_debug_output() {
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+        return false;
+
+    glEnable(GL_DEBUG_OUTPUT);
+    // keeps the callback on the calling thread, so a breakpoint in it shows the offending call
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debug_callback, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    l::info("✓ GL debug output installed");
+    return true;
+}
+
+void gl_debug_end_frame() {
+    stats.perf_last_frame = stats.perf_this_frame;
+    stats.perf_this_frame = 0;
+}
+
+const GLDebugStats &gl_debug_stats() { return stats; }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "graphics.h"
+#include <cstdint>
+#include <string>
+
+enum class GLProfile {
+    debug,   // debug context, messages routed into spdlog
+    release, // no debug context, KHR_no_error requested
+};
+
+struct GLDebugStats {
+    uint32_t perf_this_frame = 0;
+    uint32_t perf_last_frame = 0;
+    uint64_t total_messages = 0;
+    size_t unique_messages = 0;
+};
+
+std::string gl_profile_to_string(GLProfile p);
+
+// Installs the debug message callback, no-op when the context isn't a debug context.
+bool install_gl_debug_output();
+// Rolls the per-frame counters, call once per frame after swapping.
+void gl_debug_end_frame();
+const GLDebugStats &gl_debug_stats();
@@ -0,0 +1,200 @@
+#include "image_decode.h"
+#include "jobs.h"
+#include "ktx2.h"
+#include "qoi.h"
+#include "stb/stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+const char *image_format_to_string(ImageFormat f) {
+    switch (f) {
+    case ImageFormat::stb:
+        return "stb";
+    case ImageFormat::qoi:
+        return "qoi";
+    case ImageFormat::raw:
+        return "raw";
+    case ImageFormat::ktx2:
+        return "ktx2";
+    };
+    return "unknown";
+}
+
+ImageFormat detect_image_format(std::span<const std::byte> file) {
+    if (is_qoi(file))
+        return ImageFormat::qoi;
+    uint32_t magic = 0;
+    if (file.size() >= sizeof(RawImageHeader)) {
+        std::memcpy(&magic, file.data(), 4);
+        if (magic == RAW_IMAGE_MAGIC)
+            return ImageFormat::raw;
+    }
+    if (is_ktx2(file))
+        return ImageFormat::ktx2;
+    return ImageFormat::stb;
+}
+
+static DecodedImage decode_raw(const AssetData &asset) {
+    RawImageHeader header;
+    std::memcpy(&header, asset.bytes.data(), sizeof(header));
+
+    DecodedImage img{ImageFormat::raw, header.width, header.height, header.srgb != 0};
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.levels; ++i) {
+        size_t size =
+            size_t(std::max(1u, header.width >> i)) * std::max(1u, header.height >> i) * 4;
+        if (offset + size > asset.bytes.size())
+            throw std::runtime_error("raw image is truncated");
+        img.levels.push_back(asset.bytes.subspan(offset, size));
+        offset += size;
+    }
+    if (img.levels.empty())
+        throw std::runtime_error("raw image has no levels");
+    img.owner = asset.owner;
+    return img;
+}
+
+// Rows per parallel_for chunk, so small levels stay on the calling thread in one go.
+static size_t row_grain(uint32_t width) { return std::max<size_t>(1, (1 << 16) / width); }
+
+std::vector<std::vector<std::byte>> build_mip_levels(const std::byte *base, uint32_t width,
+                                                     uint32_t height, bool srgb, MipFilter filter) {
+    auto &kernels = image_kernels();
+    auto &jobs = JobSystem::get();
+    std::vector<std::vector<std::byte>> levels;
+    levels.reserve(1 + static_cast<size_t>(std::log2(std::max(width, height))));
+    auto *src = reinterpret_cast<const uint8_t *>(base);
+    uint32_t w = width, h = height;
+
+    if (filter == MipFilter::box) {
+        while (w > 1 || h > 1) {
+            uint32_t dw = std::max(1u, w / 2), dh = std::max(1u, h / 2);
+            auto &level = levels.emplace_back(size_t(dw) * dh * 4);
+            auto *dst = reinterpret_cast<uint8_t *>(level.data());
+            jobs.parallel_for(dh, row_grain(dw), [&](size_t y0, size_t y1) {
+                kernels.downsample_box(src, w, h, dst, uint32_t(y0), uint32_t(y1), srgb);
+            });
+            src = dst;
+            w = dw;
+            h = dh;
+        }
+        return levels;
+    }
+
+    // the whole chain stays in float so rounding doesn't accumulate from level to level
+    std::vector<float> cur(size_t(w) * h * 4), next;
+    jobs.parallel_for(h, row_grain(w), [&](size_t y0, size_t y1) {
+        kernels.decode_rgba8(src + y0 * w * 4, cur.data() + y0 * w * 4, (y1 - y0) * w, srgb);
+    });
+    while (w > 1 || h > 1) {
+        uint32_t dw = std::max(1u, w / 2), dh = std::max(1u, h / 2);
+        next.resize(size_t(dw) * dh * 4);
+        auto &level = levels.emplace_back(size_t(dw) * dh * 4);
+        auto *dst = reinterpret_cast<uint8_t *>(level.data());
+        jobs.parallel_for(dh, row_grain(dw), [&](size_t y0, size_t y1) {
+            kernels.downsample_kaiser(cur.data(), w, h, next.data(), uint32_t(y0), uint32_t(y1));
+            kernels.encode_rgba8(next.data() + y0 * dw * 4, dst + y0 * dw * 4, (y1 - y0) * dw,
+                                 srgb);
+        });
+        std::swap(cur, next);
+        w = dw;
+        h = dh;
+    }
+    return levels;
+}
+
+// The decoded base level plus whatever was generated from it.
+struct DecodedStorage {
+    std::shared_ptr<void> base;
+    std::vector<std::vector<std::byte>> mips;
+};
+
+static DecodedImage finish_decode(ImageFormat format, uint32_t w, uint32_t h, std::byte *pixels,
+                                  std::shared_ptr<void> owner, const DecodeOptions &opts) {
+    if (opts.premultiply) {
+        auto &kernels = image_kernels();
+        JobSystem::get().parallel_for(h, row_grain(w), [&](size_t y0, size_t y1) {
+            kernels.premultiply_alpha(reinterpret_cast<uint8_t *>(pixels) + y0 * w * 4,
+                                      (y1 - y0) * w, opts.srgb);
+        });
+    }
+
+    auto storage = std::make_shared<DecodedStorage>();
+    storage->base = std::move(owner);
+    if (opts.mips)
+        storage->mips = build_mip_levels(pixels, w, h, opts.srgb, opts.mip_filter);
+
+    DecodedImage img{format, w, h, opts.srgb};
+    img.levels.push_back({pixels, size_t(w) * h * 4});
+    for (auto &level : storage->mips)
+        img.levels.push_back(level);
+    img.owner = std::move(storage);
+    return img;
+}
+
+static DecodedImage decode_stb(const AssetData &asset, const DecodeOptions &opts) {
+    auto *bytes = reinterpret_cast<const stbi_uc *>(asset.bytes.data());
+    auto size = static_cast<int>(asset.bytes.size());
+    // the global flip flag isn't safe to touch from worker threads
+    stbi_set_flip_vertically_on_load_thread(1);
+
+    // RGB is expanded here rather than by stb, which does it a pixel at a time
+    int w, h, ch;
+    bool rgb = stbi_info_from_memory(bytes, size, &w, &h, &ch) && ch == 3;
+    auto *data = stbi_load_from_memory(bytes, size, &w, &h, &ch, rgb ? 3 : 4);
+    if (!data)
+        throw std::runtime_error(std::string("stb failed to decode image: ") +
+                                 stbi_failure_reason());
+    std::shared_ptr<stbi_uc> decoded(data, stbi_image_free);
+    if (!rgb)
+        return finish_decode(ImageFormat::stb, w, h, reinterpret_cast<std::byte *>(data),
+                             std::move(decoded), opts);
+
+    auto rgba = std::make_shared<std::vector<std::byte>>(size_t(w) * h * 4);
+    auto &kernels = image_kernels();
+    JobSystem::get().parallel_for(h, row_grain(w), [&](size_t y0, size_t y1) {
+        kernels.rgb_to_rgba(data + y0 * w * 3,
+                            reinterpret_cast<uint8_t *>(rgba->data()) + y0 * w * 4, (y1 - y0) * w);
+    });
+    return finish_decode(ImageFormat::stb, w, h, rgba->data(), rgba, opts);
+}
+
+DecodedImage decode_image(const AssetData &asset, const DecodeOptions &opts) {
+    switch (detect_image_format(asset.bytes)) {
+    case ImageFormat::raw:
+        return decode_raw(asset);
+
+    case ImageFormat::qoi: {
+        auto qoi = std::make_shared<QoiImage>(qoi_decode(asset.bytes, true));
+        return finish_decode(ImageFormat::qoi, qoi->width, qoi->height, qoi->pixels.data(), qoi,
+                             opts);
+    }
+
+    case ImageFormat::stb:
+        return decode_stb(asset, opts);
+
+    case ImageFormat::ktx2:
+        break;
+    }
+    throw std::runtime_error("KTX2 files are uploaded as stored, not decoded");
+}
+
+std::vector<std::byte> write_raw_image(uint32_t width, uint32_t height, bool srgb,
+                                       std::span<const std::vector<std::byte>> levels) {
+    RawImageHeader header{RAW_IMAGE_MAGIC, width, height, static_cast<uint32_t>(levels.size()),
+                          srgb ? 1u : 0u};
+    size_t total = sizeof(header);
+    for (auto &level : levels)
+        total += level.size();
+
+    std::vector<std::byte> out(total);
+    std::memcpy(out.data(), &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (auto &level : levels) {
+        std::memcpy(out.data() + offset, level.data(), level.size());
+        offset += level.size();
+    }
+    return out;
+}
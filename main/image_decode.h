@@ -0,0 +1,68 @@
+#pragma once
+
+#include "asset_pack.h"
+#include "image_kernels.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class ImageFormat {
+    stb,  // anything stb_image understands, PNG mostly
+    qoi,  // single pass lossless decode
+    raw,  // pre-swizzled RGBA8 with its mips, see RawImageHeader
+    ktx2, // GPU formats, uploaded without decoding by opengl_helpers/ktx_texture.hpp
+};
+
+const char *image_format_to_string(ImageFormat f);
+// Sniffs the magic bytes, anything unrecognized is left to stb.
+ImageFormat detect_image_format(std::span<const std::byte> file);
+
+constexpr uint32_t RAW_IMAGE_MAGIC = 0x57524346; // "FCRW"
+
+// Raw image layout: this header, then every level (level 0 first) as RGBA8 rows bottom-up.
+struct RawImageHeader {
+    uint32_t magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t srgb;
+};
+
+/**
+ * \brief RGBA8 pixels with rows bottom-up, ready for upload. Raw images point into the asset
+ * itself, decoded ones into a buffer owned by `owner`.
+ */
+struct DecodedImage {
+    ImageFormat format = ImageFormat::stb;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool srgb = false; // color is sRGB encoded, from DecodeOptions or the raw header
+    std::vector<std::span<const std::byte>> levels;
+    std::shared_ptr<const void> owner;
+};
+
+// CPU side preparation applied while decoding. Raw images are stored ready to upload and skip it.
+struct DecodeOptions {
+    bool srgb = false;        // filter mips in linear space
+    bool premultiply = false; // multiply color by alpha before building mips
+    bool mips = false;        // build the full chain down to 1x1
+    MipFilter mip_filter = MipFilter::box;
+};
+
+/**
+ * \brief Decodes a stb, QOI or raw image. Safe to call from any thread, throws std::runtime_error
+ * on failure and on KTX2 files, which are never decoded on the CPU. Mip generation is spread over
+ * the job system.
+ */
+DecodedImage decode_image(const AssetData &asset, const DecodeOptions &opts = {});
+
+/**
+ * \brief Downsamples `base` (RGBA8, w x h) down to 1x1 and returns levels 1 and up. Each level is
+ * split by rows across the job system, using the best kernels this CPU supports.
+ */
+std::vector<std::vector<std::byte>> build_mip_levels(const std::byte *base, uint32_t width,
+                                                     uint32_t height, bool srgb, MipFilter filter);
+
+// Serializes RGBA8 levels (level 0 first, rows bottom-up) as a raw image.
+std::vector<std::byte> write_raw_image(uint32_t width, uint32_t height, bool srgb,
+                                       std::span<const std::vector<std::byte>> levels);
@@ -0,0 +1,191 @@
+#include "image_kernels.h"
+#include "image_kernels_impl.h"
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+const char *mip_filter_to_string(MipFilter f) {
+    switch (f) {
+    case MipFilter::box:
+        return "box";
+    case MipFilter::kaiser:
+        return "kaiser";
+    };
+    return "unknown";
+}
+
+const float *decode_lut(bool srgb) {
+    static const auto tables = [] {
+        std::array<std::array<float, 4 * 256>, 2> t{};
+        for (int v = 0; v < 256; ++v) {
+            float c = v / 255.0f;
+            float lin = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            for (int ch = 0; ch < 4; ++ch) {
+                t[0][ch * 256 + v] = c;
+                t[1][ch * 256 + v] = ch < 3 ? lin : c;
+            }
+        }
+        return t;
+    }();
+    return tables[srgb].data();
+}
+
+const float *srgb_encode_thresholds() {
+    static const auto table = [] {
+        std::array<float, 4 * 256> t{};
+        for (int v = 0; v < 256; ++v) {
+            // the midpoint between bytes v and v + 1 decoded in double, then the first float at
+            // or above it so comparing a float against it is exact
+            double c = (v + 0.5) / 255;
+            double lin = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            for (int ch = 0; ch < 4; ++ch) {
+                double mid = ch < 3 ? lin : c;
+                float f = static_cast<float>(mid);
+                if (f < mid)
+                    f = std::nextafter(f, 2.0f);
+                t[ch * 256 + v] = v < 255 ? f : std::numeric_limits<float>::infinity();
+            }
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+const uint8_t *srgb_encode_lut() {
+    static const auto table = [] {
+        auto *next = srgb_encode_thresholds();
+        std::array<uint8_t, 4 * ENCODE_STEPS + 3> t{};
+        for (int i = 0; i < ENCODE_STEPS; ++i) {
+            // lowest float landing in step i, which float rounding can put just below i / steps
+            float c = i / float(ENCODE_STEPS - 1);
+            while (c > 0 && static_cast<int>(std::nextafter(c, 0.0f) * (ENCODE_STEPS - 1)) == i)
+                c = std::nextafter(c, 0.0f);
+            for (int ch = 0; ch < 4; ++ch) {
+                auto first = next + ch * 256;
+                t[ch * ENCODE_STEPS + i] =
+                    static_cast<uint8_t>(std::upper_bound(first, first + 256, c) - first);
+            }
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+const std::array<float, KAISER_TAPS> &kaiser_weights() {
+    static const auto weights = [] {
+        // zeroth order modified Bessel function of the first kind
+        auto bessel_i0 = [](double x) {
+            double sum = 1, term = 1;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        };
+        constexpr double ALPHA = 4.0, RADIUS = KAISER_TAPS / 2;
+        std::array<float, KAISER_TAPS> w{};
+        double total = 0;
+        for (int t = 0; t < KAISER_TAPS; ++t) {
+            // distance from the output pixel center in source pixels, sinc scaled for 2x
+            double d = t - (KAISER_TAPS - 1) / 2.0;
+            double x = d / 2 * std::numbers::pi;
+            double sinc = std::sin(x) / x;
+            double r = d / RADIUS;
+            double window = bessel_i0(ALPHA * std::sqrt(1 - r * r)) / bessel_i0(ALPHA);
+            w[t] = static_cast<float>(sinc * window);
+            total += w[t];
+        }
+        for (auto &v : w)
+            v = static_cast<float>(v / total);
+        return w;
+    }();
+    return weights;
+}
+
+static void downsample_box_scalar(const uint8_t *src, uint32_t w, uint32_t h, uint8_t *dst,
+                                  uint32_t y0, uint32_t y1, bool srgb) {
+    uint32_t dw = std::max(1u, w / 2);
+    for (uint32_t y = y0; y < y1; ++y) {
+        auto *r0 = src + size_t(std::min(y * 2, h - 1)) * w * 4;
+        auto *r1 = src + size_t(std::min(y * 2 + 1, h - 1)) * w * 4;
+        for (uint32_t x = 0; x < dw; ++x)
+            box_pixel(r0, r1, std::min(x * 2, w - 1), std::min(x * 2 + 1, w - 1),
+                      dst + (size_t(y) * dw + x) * 4, srgb);
+    }
+}
+
+static void downsample_kaiser_scalar(const float *src, uint32_t w, uint32_t h, float *dst,
+                                     uint32_t y0, uint32_t y1) {
+    auto &k = kaiser_weights();
+    uint32_t dw = std::max(1u, w / 2);
+    size_t stride = size_t(w) * 4;
+    std::vector<float> row(stride);
+    for (uint32_t y = y0; y < y1; ++y) {
+        // vertical pass into a full width row, then the horizontal one straight to dst
+        std::fill(row.begin(), row.end(), 0.0f);
+        for (int t = 0; t < KAISER_TAPS; ++t) {
+            auto *in = src + std::clamp(int(y) * 2 - 3 + t, 0, int(h) - 1) * stride;
+            for (size_t i = 0; i < stride; ++i)
+                row[i] += k[t] * in[i];
+        }
+        for (uint32_t x = 0; x < dw; ++x)
+            kaiser_pixel(row.data(), w, x, dst + (size_t(y) * dw + x) * 4);
+    }
+}
+
+static void decode_rgba8_scalar(const uint8_t *src, float *dst, size_t pixels, bool srgb) {
+    auto *lut = decode_lut(srgb);
+    for (size_t i = 0; i < pixels * 4; ++i)
+        dst[i] = lut[(i & 3) * 256 + src[i]];
+}
+
+static void encode_rgba8_scalar(const float *src, uint8_t *dst, size_t pixels, bool srgb) {
+    if (!srgb) {
+        for (size_t i = 0; i < pixels * 4; ++i)
+            dst[i] = static_cast<uint8_t>(std::clamp(src[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        return;
+    }
+    auto *lut = srgb_encode_lut();
+    auto *next = srgb_encode_thresholds();
+    for (size_t i = 0; i < pixels * 4; ++i)
+        dst[i] = encode_srgb(src[i], int(i & 3), lut, next);
+}
+
+static void premultiply_alpha_scalar(uint8_t *rgba, size_t pixels, bool srgb) {
+    for (size_t i = 0; i < pixels; ++i)
+        premultiply_pixel(rgba + i * 4, srgb);
+}
+
+static void rgb_to_rgba_scalar(const uint8_t *rgb, uint8_t *rgba, size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+const ImageKernels &image_kernels_scalar() {
+    static const ImageKernels kernels{
+        .level = SimdLevel::scalar,
+        .downsample_box = downsample_box_scalar,
+        .downsample_kaiser = downsample_kaiser_scalar,
+        .decode_rgba8 = decode_rgba8_scalar,
+        .encode_rgba8 = encode_rgba8_scalar,
+        .premultiply_alpha = premultiply_alpha_scalar,
+        .rgb_to_rgba = rgb_to_rgba_scalar,
+    };
+    return kernels;
+}
+
+const ImageKernels &image_kernels(SimdLevel level) {
+    level = std::min(level, best_simd_level());
+#if CPU_X86
+    if (level >= SimdLevel::avx2)
+        return image_kernels_avx2();
+    if (level == SimdLevel::sse41)
+        return image_kernels_sse41();
+#endif
+    return image_kernels_scalar();
+}
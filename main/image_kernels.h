@@ -0,0 +1,35 @@
+#pragma once
+
+#include "cpu_features.h"
+#include <cstddef>
+#include <cstdint>
+
+// CPU image kernels used to prepare textures off the GL thread. Pixels are RGBA8 or RGBA32F with
+// tightly packed rows. With `srgb` the color channels are converted to linear before any
+// arithmetic, alpha is always linear.
+
+enum class MipFilter {
+    box,    // 2x2 average, fast
+    kaiser, // 8 tap Kaiser windowed sinc, sharper distant mips, works in float
+};
+
+const char *mip_filter_to_string(MipFilter f);
+
+/**
+ * \brief One implementation of every kernel. The downsamplers write output rows [y0, y1) of a
+ * max(1, w/2) x max(1, h/2) image, so callers can split a level across threads.
+ */
+struct ImageKernels {
+    SimdLevel level;
+    void (*downsample_box)(const uint8_t *src, uint32_t w, uint32_t h, uint8_t *dst, uint32_t y0,
+                           uint32_t y1, bool srgb);
+    void (*downsample_kaiser)(const float *src, uint32_t w, uint32_t h, float *dst, uint32_t y0,
+                              uint32_t y1);
+    void (*decode_rgba8)(const uint8_t *src, float *dst, size_t pixels, bool srgb);
+    void (*encode_rgba8)(const float *src, uint8_t *dst, size_t pixels, bool srgb);
+    void (*premultiply_alpha)(uint8_t *rgba, size_t pixels, bool srgb);
+    void (*rgb_to_rgba)(const uint8_t *rgb, uint8_t *rgba, size_t pixels);
+};
+
+// Kernels for `level`, or the best this CPU runs when `level` isn't supported.
+const ImageKernels &image_kernels(SimdLevel level = best_simd_level());
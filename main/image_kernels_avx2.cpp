@@ -0,0 +1,283 @@
+#include "image_kernels_impl.h"
+#include <vector>
+
+#if CPU_X86
+// Only the kernels below may use AVX2: includes come first so inline library code the linker
+// could share with other files keeps the baseline ISA. MSVC needs no switch for intrinsics, and
+// no /arch:AVX2 on this file for the same reason.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+
+// sRGB conversions gather from the same tables the scalar kernels use, so every flavor produces
+// the same bytes up to float rounding.
+
+// Offsets of each channel's table for two RGBA pixels in one register.
+static __m256i channel_offsets(int steps) {
+    return _mm256_setr_epi32(0, steps, 2 * steps, 3 * steps, 0, steps, 2 * steps, 3 * steps);
+}
+
+// Two RGBA8 pixels to 8 floats through `lut`.
+static __m256 decode2(const uint8_t *p, const float *lut) {
+    __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+    return _mm256_i32gather_ps(lut, _mm256_add_epi32(idx, channel_offsets(256)), 4);
+}
+
+// 8 linear floats to two sRGB encoded pixels.
+static void encode2(__m256 v, uint8_t *out, const uint8_t *lut, const float *next) {
+    __m256 clamped = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    __m256i idx = _mm256_cvttps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(ENCODE_STEPS - 1)));
+    // byte table, so gather 32 bits at byte granularity and keep the low byte
+    __m256i bytes = _mm256_and_si256(
+        _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut),
+                               _mm256_add_epi32(idx, channel_offsets(ENCODE_STEPS)), 1),
+        _mm256_set1_epi32(0xff));
+    // one step up where the value reaches the next byte's threshold, the mask is -1 there
+    __m256 threshold =
+        _mm256_i32gather_ps(next, _mm256_add_epi32(bytes, channel_offsets(256)), 4);
+    bytes = _mm256_sub_epi32(
+        bytes, _mm256_castps_si256(_mm256_cmp_ps(clamped, threshold, _CMP_GE_OQ)));
+    __m256i words = _mm256_packus_epi32(bytes, bytes);
+    __m256i packed = _mm256_packus_epi16(words, words);
+    __m128i two = _mm_unpacklo_epi32(_mm256_castsi256_si128(packed),
+                                     _mm256_extracti128_si256(packed, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), two);
+}
+
+// (v * a + 128) / 255 rounded, per 16 bit lane
+static __m256i div255(__m256i v) {
+    v = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+}
+
+static void downsample_box_avx2(const uint8_t *src, uint32_t w, uint32_t h, uint8_t *dst,
+                                uint32_t y0, uint32_t y1, bool srgb) {
+    uint32_t dw = std::max(1u, w / 2);
+    auto *dec = decode_lut(true);
+    auto *enc = srgb_encode_lut();
+    auto *next = srgb_encode_thresholds();
+    const __m256i zero = _mm256_setzero_si256(), two = _mm256_set1_epi16(2);
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        auto *r0 = src + size_t(std::min(y * 2, h - 1)) * w * 4;
+        auto *r1 = src + size_t(std::min(y * 2 + 1, h - 1)) * w * 4;
+        auto *out = dst + size_t(y) * dw * 4;
+        uint32_t x = 0;
+        if (w == 1) {
+            // the only case where the right neighbour needs clamping
+        } else if (!srgb) {
+            // 16 source pixels per row into 8 output pixels
+            for (; x + 8 <= dw; x += 8) {
+                __m256i res[2];
+                for (int half = 0; half < 2; ++half) {
+                    auto off = (x * 2 + half * 8) * 4;
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r0 + off));
+                    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r1 + off));
+                    // unpacks stay within 128 bit lanes: lo = p0 p1 | p4 p5, hi = p2 p3 | p6 p7
+                    __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero),
+                                                  _mm256_unpacklo_epi8(b, zero));
+                    __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero),
+                                                  _mm256_unpackhi_epi8(b, zero));
+                    __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi),
+                                                   _mm256_unpackhi_epi64(lo, hi));
+                    res[half] = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+                }
+                // the pack interleaves lanes, put output pixels back in order
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(res[0], res[1]),
+                                                          _MM_SHUFFLE(3, 1, 2, 0));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x * 4), packed);
+            }
+        } else {
+            // 4 source pixels per row into 2 output pixels
+            for (; x + 2 <= dw; x += 2) {
+                auto *a = r0 + x * 8, *b = r1 + x * 8;
+                __m256 first = _mm256_add_ps(decode2(a, dec), decode2(b, dec));
+                __m256 second = _mm256_add_ps(decode2(a + 8, dec), decode2(b + 8, dec));
+                __m256 left = _mm256_permute2f128_ps(first, second, 0x20);
+                __m256 right = _mm256_permute2f128_ps(first, second, 0x31);
+                encode2(_mm256_mul_ps(_mm256_add_ps(left, right), _mm256_set1_ps(0.25f)),
+                        out + x * 4, enc, next);
+                out[x * 4 + 3] = box_alpha(a, b);
+                out[x * 4 + 7] = box_alpha(a + 8, b + 8);
+            }
+        }
+        for (; x < dw; ++x)
+            box_pixel(r0, r1, std::min(x * 2, w - 1), std::min(x * 2 + 1, w - 1), out + x * 4,
+                      srgb);
+    }
+}
+
+static void downsample_kaiser_avx2(const float *src, uint32_t w, uint32_t h, float *dst,
+                                   uint32_t y0, uint32_t y1) {
+    auto &k = kaiser_weights();
+    uint32_t dw = std::max(1u, w / 2);
+    size_t stride = size_t(w) * 4;
+    std::vector<float> row(stride);
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        const float *rows[KAISER_TAPS];
+        for (int t = 0; t < KAISER_TAPS; ++t)
+            rows[t] = src + std::clamp(int(y) * 2 - 3 + t, 0, int(h) - 1) * stride;
+        size_t i = 0;
+        for (; i + 8 <= stride; i += 8) {
+            __m256 acc = _mm256_setzero_ps();
+            for (int t = 0; t < KAISER_TAPS; ++t)
+                acc = _mm256_fmadd_ps(_mm256_set1_ps(k[t]), _mm256_loadu_ps(rows[t] + i), acc);
+            _mm256_storeu_ps(row.data() + i, acc);
+        }
+        // odd widths leave one pixel
+        for (; i < stride; ++i) {
+            float acc = 0;
+            for (int t = 0; t < KAISER_TAPS; ++t)
+                acc += k[t] * rows[t][i];
+            row[i] = acc;
+        }
+
+        // two output pixels per register where both have all taps inside the row, their taps
+        // start 2 source pixels apart
+        auto *out = dst + size_t(y) * dw * 4;
+        for (uint32_t x = 0; x < dw; ++x) {
+            int first = int(x) * 2 - 3;
+            if (first >= 0 && x + 2 <= dw && first + 2 + KAISER_TAPS <= int(w)) {
+                __m256 acc = _mm256_setzero_ps();
+                for (int t = 0; t < KAISER_TAPS; ++t) {
+                    auto *p = row.data() + (first + t) * 4;
+                    acc = _mm256_fmadd_ps(_mm256_set1_ps(k[t]),
+                                          _mm256_loadu2_m128(p + 8, p), acc);
+                }
+                _mm256_storeu_ps(out + x * 4, acc);
+                ++x;
+            } else {
+                kaiser_pixel(row.data(), w, x, out + x * 4);
+            }
+        }
+    }
+}
+
+static void decode_rgba8_avx2(const uint8_t *src, float *dst, size_t pixels, bool srgb) {
+    size_t i = 0;
+    if (srgb) {
+        auto *lut = decode_lut(true);
+        for (; i + 2 <= pixels; i += 2)
+            _mm256_storeu_ps(dst + i * 4, decode2(src + i * 4, lut));
+    } else {
+        const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+        for (; i + 2 <= pixels; i += 2) {
+            __m256i v = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i * 4)));
+            _mm256_storeu_ps(dst + i * 4, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+        }
+    }
+    auto *lut = decode_lut(srgb);
+    for (; i < pixels; ++i)
+        for (int c = 0; c < 4; ++c)
+            dst[i * 4 + c] = lut[c * 256 + src[i * 4 + c]];
+}
+
+static void encode_rgba8_avx2(const float *src, uint8_t *dst, size_t pixels, bool srgb) {
+    size_t i = 0;
+    if (srgb) {
+        auto *lut = srgb_encode_lut();
+        auto *next = srgb_encode_thresholds();
+        for (; i + 2 <= pixels; i += 2)
+            encode2(_mm256_loadu_ps(src + i * 4), dst + i * 4, lut, next);
+        for (; i < pixels; ++i)
+            for (int c = 0; c < 4; ++c)
+                dst[i * 4 + c] = encode_srgb(src[i * 4 + c], c, lut, next);
+        return;
+    }
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    // restores pixel order after the in-lane packs
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i v[4];
+        for (int p = 0; p < 4; ++p)
+            v[p] = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + (i + p * 2) * 4), scale));
+        // saturating packs do the clamping
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v[0], v[1]),
+                                             _mm256_packs_epi32(v[2], v[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4),
+                            _mm256_permutevar8x32_epi32(packed, order));
+    }
+    for (; i < pixels; ++i)
+        for (int c = 0; c < 4; ++c)
+            dst[i * 4 + c] =
+                static_cast<uint8_t>(std::clamp(src[i * 4 + c], 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void premultiply_alpha_avx2(uint8_t *rgba, size_t pixels, bool srgb) {
+    size_t i = 0;
+    if (srgb) {
+        auto *dec = decode_lut(true);
+        auto *enc = srgb_encode_lut();
+        auto *next = srgb_encode_thresholds();
+        for (; i + 2 <= pixels; i += 2) {
+            __m256 v = decode2(rgba + i * 4, dec);
+            __m256 alpha = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+            encode2(_mm256_blend_ps(_mm256_mul_ps(v, alpha), v, 0x88), rgba + i * 4, enc, next);
+        }
+    } else {
+        const __m256i zero = _mm256_setzero_si256();
+        // copies each pixel's 16 bit alpha to all four of its lanes
+        const __m256i alpha =
+            _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15, 6, 7, 6, 7, 6,
+                             7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+        for (; i + 8 <= pixels; i += 8) {
+            auto *p = reinterpret_cast<__m256i *>(rgba + i * 4);
+            __m256i v = _mm256_loadu_si256(p);
+            __m256i res[2];
+            for (int half = 0; half < 2; ++half) {
+                __m256i c = half ? _mm256_unpackhi_epi8(v, zero) : _mm256_unpacklo_epi8(v, zero);
+                __m256i m = div255(_mm256_mullo_epi16(c, _mm256_shuffle_epi8(c, alpha)));
+                res[half] = _mm256_blend_epi16(m, c, 0x88);
+            }
+            // unpack and pack both work within lanes, so the order comes back as it was
+            _mm256_storeu_si256(p, _mm256_packus_epi16(res[0], res[1]));
+        }
+    }
+    for (; i < pixels; ++i)
+        premultiply_pixel(rgba + i * 4, srgb);
+}
+
+static void rgb_to_rgba_avx2(const uint8_t *rgb, uint8_t *rgba, size_t pixels) {
+    // bytes 0-11 to the low lane and 12-23 to the high lane, then the same shuffle in each
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0,
+                                            1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i opaque = _mm256_set1_epi32(0xff000000);
+    size_t i = 0;
+    // 32 byte loads for 24 bytes of input, stop early enough not to read past the end
+    for (; i + 11 <= pixels; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgb + i * 3));
+        v = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(v, lanes), spread);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba + i * 4), _mm256_or_si256(v, opaque));
+    }
+    for (; i < pixels; ++i) {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const ImageKernels &image_kernels_avx2() {
+    static const ImageKernels kernels{
+        .level = SimdLevel::avx2,
+        .downsample_box = downsample_box_avx2,
+        .downsample_kaiser = downsample_kaiser_avx2,
+        .decode_rgba8 = decode_rgba8_avx2,
+        .encode_rgba8 = encode_rgba8_avx2,
+        .premultiply_alpha = premultiply_alpha_avx2,
+        .rgb_to_rgba = rgb_to_rgba_avx2,
+    };
+    return kernels;
+}
+#endif
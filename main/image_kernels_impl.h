@@ -0,0 +1,92 @@
+#pragma once
+
+// Shared by the image_kernels*.cpp files, everything else goes through image_kernels.h.
+
+#include "image_kernels.h"
+#include <algorithm>
+#include <array>
+
+constexpr int KAISER_TAPS = 8;
+constexpr int ENCODE_STEPS = 4096;
+
+// 4 x 256 floats, channel c of byte value v at [c * 256 + v]. The sRGB table decodes alpha
+// linearly, so both are indexed the same way.
+const float *decode_lut(bool srgb);
+// 4 x ENCODE_STEPS bytes, the encoded value at the start of each of ENCODE_STEPS equal steps over
+// [0, 1]. sRGB for the color channels, alpha stays linear. Same channel layout as decode_lut(),
+// padded so 32 bit gathers of the last entry stay in bounds.
+const uint8_t *srgb_encode_lut();
+// 4 x 256 floats, the smallest linear value that encodes to byte v + 1 (infinity for 255). Steps
+// are narrow enough to hold at most one of these, so one compare moves the table's byte to the
+// exactly rounded one.
+const float *srgb_encode_thresholds();
+// Weights for source pixels 2x - 3 ... 2x + 4 of output pixel x, normalized.
+const std::array<float, KAISER_TAPS> &kaiser_weights();
+
+// Linear `v` of channel `c` rounded to the nearest byte on the exact curve.
+inline uint8_t encode_srgb(float v, int c, const uint8_t *lut, const float *next) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    uint8_t b = lut[c * ENCODE_STEPS + static_cast<int>(v * (ENCODE_STEPS - 1))];
+    return b + (v >= next[c * 256 + b]);
+}
+
+// Alpha of the box filtered pixel over pixel pairs `a` and `b`, averaged as integers so the
+// sRGB path rounds alpha exactly like the linear one.
+inline uint8_t box_alpha(const uint8_t *a, const uint8_t *b) {
+    return static_cast<uint8_t>((a[3] + a[7] + b[3] + b[7] + 2) >> 2);
+}
+
+// Scalar fallbacks the SIMD kernels use for their edges.
+
+inline void box_pixel(const uint8_t *r0, const uint8_t *r1, uint32_t x0, uint32_t x1,
+                      uint8_t *out, bool srgb) {
+    const uint8_t *p[4] = {r0 + x0 * 4, r0 + x1 * 4, r1 + x0 * 4, r1 + x1 * 4};
+    if (!srgb) {
+        for (int c = 0; c < 4; ++c)
+            out[c] = static_cast<uint8_t>((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) >> 2);
+        return;
+    }
+    auto *dec = decode_lut(true);
+    auto *enc = srgb_encode_lut();
+    auto *next = srgb_encode_thresholds();
+    for (int c = 0; c < 3; ++c) {
+        const float *t = dec + c * 256;
+        float avg = (t[p[0][c]] + t[p[1][c]] + t[p[2][c]] + t[p[3][c]]) * 0.25f;
+        out[c] = encode_srgb(avg, c, enc, next);
+    }
+    out[3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) >> 2);
+}
+
+inline void kaiser_pixel(const float *row, uint32_t w, uint32_t x, float *out) {
+    auto &k = kaiser_weights();
+    float acc[4] = {};
+    for (int t = 0; t < KAISER_TAPS; ++t) {
+        int sx = std::clamp(int(x) * 2 - 3 + t, 0, int(w) - 1);
+        for (int c = 0; c < 4; ++c)
+            acc[c] += k[t] * row[sx * 4 + c];
+    }
+    for (int c = 0; c < 4; ++c)
+        out[c] = acc[c];
+}
+
+inline void premultiply_pixel(uint8_t *p, bool srgb) {
+    if (!srgb) {
+        for (int c = 0; c < 3; ++c) {
+            uint32_t v = p[c] * p[3] + 128;
+            p[c] = static_cast<uint8_t>((v + (v >> 8)) >> 8);
+        }
+        return;
+    }
+    auto *dec = decode_lut(true);
+    auto *enc = srgb_encode_lut();
+    auto *next = srgb_encode_thresholds();
+    float a = p[3] / 255.0f;
+    for (int c = 0; c < 3; ++c)
+        p[c] = encode_srgb(dec[c * 256 + p[c]] * a, c, enc, next);
+}
+
+const ImageKernels &image_kernels_scalar();
+#if CPU_X86
+const ImageKernels &image_kernels_sse41();
+const ImageKernels &image_kernels_avx2();
+#endif
@@ -0,0 +1,222 @@
+#include "image_kernels_impl.h"
+#include <cstring>
+#include <vector>
+
+#if CPU_X86
+// includes stay above the target switch, see image_kernels_avx2.cpp
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("sse4.1")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+
+// sRGB paths have no gather before AVX2, so they only vectorize the arithmetic between scalar
+// table lookups.
+
+static __m128 decode_pixel(const uint8_t *p, const float *lut) {
+    return _mm_setr_ps(lut[p[0]], lut[256 + p[1]], lut[512 + p[2]], lut[768 + p[3]]);
+}
+
+static void encode_pixel(__m128 v, uint8_t *out, const uint8_t *lut, const float *next) {
+    __m128 clamped = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    alignas(16) float val[4];
+    alignas(16) int idx[4];
+    _mm_store_ps(val, clamped);
+    _mm_store_si128(reinterpret_cast<__m128i *>(idx),
+                    _mm_cvttps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(ENCODE_STEPS - 1))));
+    for (int c = 0; c < 4; ++c) {
+        uint8_t b = lut[c * ENCODE_STEPS + idx[c]];
+        out[c] = b + (val[c] >= next[c * 256 + b]);
+    }
+}
+
+// (v * a + 128) / 255 rounded, per 16 bit lane
+static __m128i div255(__m128i v) {
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+static void downsample_box_sse41(const uint8_t *src, uint32_t w, uint32_t h, uint8_t *dst,
+                                 uint32_t y0, uint32_t y1, bool srgb) {
+    uint32_t dw = std::max(1u, w / 2);
+    auto *dec = decode_lut(true);
+    auto *enc = srgb_encode_lut();
+    auto *next = srgb_encode_thresholds();
+    const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        auto *r0 = src + size_t(std::min(y * 2, h - 1)) * w * 4;
+        auto *r1 = src + size_t(std::min(y * 2 + 1, h - 1)) * w * 4;
+        auto *out = dst + size_t(y) * dw * 4;
+        uint32_t x = 0;
+        if (w == 1) {
+            // the only case where the right neighbour needs clamping
+        } else if (!srgb) {
+            // 8 source pixels per row into 4 output pixels
+            for (; x + 4 <= dw; x += 4) {
+                __m128i res[2];
+                for (int half = 0; half < 2; ++half) {
+                    auto off = (x * 2 + half * 4) * 4;
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + off));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + off));
+                    // pixels 0, 1 and 2, 3 of both rows summed as 16 bit
+                    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                               _mm_unpacklo_epi8(b, zero));
+                    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                               _mm_unpackhi_epi8(b, zero));
+                    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                                                _mm_unpackhi_epi64(lo, hi));
+                    res[half] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4),
+                                 _mm_packus_epi16(res[0], res[1]));
+            }
+        } else {
+            for (; x < dw; ++x) {
+                auto *a = r0 + x * 8, *b = r1 + x * 8;
+                __m128 sum = _mm_add_ps(_mm_add_ps(decode_pixel(a, dec), decode_pixel(a + 4, dec)),
+                                        _mm_add_ps(decode_pixel(b, dec), decode_pixel(b + 4, dec)));
+                encode_pixel(_mm_mul_ps(sum, _mm_set1_ps(0.25f)), out + x * 4, enc, next);
+                out[x * 4 + 3] = box_alpha(a, b);
+            }
+        }
+        for (; x < dw; ++x)
+            box_pixel(r0, r1, std::min(x * 2, w - 1), std::min(x * 2 + 1, w - 1), out + x * 4,
+                      srgb);
+    }
+}
+
+static void downsample_kaiser_sse41(const float *src, uint32_t w, uint32_t h, float *dst,
+                                    uint32_t y0, uint32_t y1) {
+    auto &k = kaiser_weights();
+    uint32_t dw = std::max(1u, w / 2);
+    size_t stride = size_t(w) * 4;
+    std::vector<float> row(stride);
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        const float *rows[KAISER_TAPS];
+        for (int t = 0; t < KAISER_TAPS; ++t)
+            rows[t] = src + std::clamp(int(y) * 2 - 3 + t, 0, int(h) - 1) * stride;
+        // every row length is a multiple of 4 floats
+        for (size_t i = 0; i < stride; i += 4) {
+            __m128 acc = _mm_setzero_ps();
+            for (int t = 0; t < KAISER_TAPS; ++t)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k[t]), _mm_loadu_ps(rows[t] + i)));
+            _mm_storeu_ps(row.data() + i, acc);
+        }
+
+        auto *out = dst + size_t(y) * dw * 4;
+        for (uint32_t x = 0; x < dw; ++x) {
+            int first = int(x) * 2 - 3;
+            if (first < 0 || first + KAISER_TAPS > int(w)) {
+                kaiser_pixel(row.data(), w, x, out + x * 4);
+                continue;
+            }
+            __m128 acc = _mm_setzero_ps();
+            for (int t = 0; t < KAISER_TAPS; ++t)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k[t]),
+                                                 _mm_loadu_ps(row.data() + (first + t) * 4)));
+            _mm_storeu_ps(out + x * 4, acc);
+        }
+    }
+}
+
+static void decode_rgba8_sse41(const uint8_t *src, float *dst, size_t pixels, bool srgb) {
+    if (srgb) {
+        auto *lut = decode_lut(true);
+        for (size_t i = 0; i < pixels; ++i)
+            _mm_storeu_ps(dst + i * 4, decode_pixel(src + i * 4, lut));
+        return;
+    }
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    for (size_t i = 0; i < pixels; ++i) {
+        int packed;
+        std::memcpy(&packed, src + i * 4, 4);
+        __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+        _mm_storeu_ps(dst + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+}
+
+static void encode_rgba8_sse41(const float *src, uint8_t *dst, size_t pixels, bool srgb) {
+    if (srgb) {
+        auto *lut = srgb_encode_lut();
+        auto *next = srgb_encode_thresholds();
+        for (size_t i = 0; i < pixels; ++i)
+            encode_pixel(_mm_loadu_ps(src + i * 4), dst + i * 4, lut, next);
+        return;
+    }
+    const __m128 scale = _mm_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i v[4];
+        for (int p = 0; p < 4; ++p)
+            v[p] = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + (i + p) * 4), scale));
+        // saturating packs do the clamping
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), packed);
+    }
+    for (; i < pixels; ++i)
+        for (int c = 0; c < 4; ++c)
+            dst[i * 4 + c] =
+                static_cast<uint8_t>(std::clamp(src[i * 4 + c], 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void premultiply_alpha_sse41(uint8_t *rgba, size_t pixels, bool srgb) {
+    size_t i = 0;
+    if (!srgb) {
+        const __m128i zero = _mm_setzero_si128();
+        // copies each pixel's 16 bit alpha to all four of its lanes
+        const __m128i alpha = _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+        for (; i + 4 <= pixels; i += 4) {
+            auto *p = reinterpret_cast<__m128i *>(rgba + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i res[2];
+            for (int half = 0; half < 2; ++half) {
+                __m128i c = half ? _mm_unpackhi_epi8(v, zero) : _mm_unpacklo_epi8(v, zero);
+                __m128i m = div255(_mm_mullo_epi16(c, _mm_shuffle_epi8(c, alpha)));
+                res[half] = _mm_blend_epi16(m, c, 0x88);
+            }
+            _mm_storeu_si128(p, _mm_packus_epi16(res[0], res[1]));
+        }
+    }
+    for (; i < pixels; ++i)
+        premultiply_pixel(rgba + i * 4, srgb);
+}
+
+static void rgb_to_rgba_sse41(const uint8_t *rgb, uint8_t *rgba, size_t pixels) {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i opaque = _mm_set1_epi32(0xff000000);
+    size_t i = 0;
+    // 16 byte loads for 12 bytes of input, stop early enough not to read past the end
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + i * 4),
+                         _mm_or_si128(_mm_shuffle_epi8(v, spread), opaque));
+    }
+    for (; i < pixels; ++i) {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const ImageKernels &image_kernels_sse41() {
+    static const ImageKernels kernels{
+        .level = SimdLevel::sse41,
+        .downsample_box = downsample_box_sse41,
+        .downsample_kaiser = downsample_kaiser_sse41,
+        .decode_rgba8 = decode_rgba8_sse41,
+        .encode_rgba8 = encode_rgba8_sse41,
+        .premultiply_alpha = premultiply_alpha_sse41,
+        .rgb_to_rgba = rgb_to_rgba_sse41,
+    };
+    return kernels;
+}
+#endif
@@ -0,0 +1,88 @@
+#include "jobs.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+JobSystem::JobSystem() {
+    // the main thread is busy with GL, at least one worker even on a single core
+    unsigned count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+        workers.emplace_back([this] { work(); });
+    spdlog::info("✓ job system started with {} workers", workers.size());
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    // join before the queue and the condition variable the workers wait on are destroyed
+    workers.clear();
+}
+
+void JobSystem::push(std::function<void()> job) {
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void JobSystem::work() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping && queue.empty())
+                return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
+
+void JobSystem::parallel_for(size_t count, size_t grain,
+                             const std::function<void(size_t, size_t)> &fn) {
+    if (count == 0)
+        return;
+    grain = std::max<size_t>(1, grain);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1) {
+        fn(0, count);
+        return;
+    }
+
+    // shared so helpers that only get scheduled after everything is done can still look at it
+    struct Range {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        size_t count, grain, chunks;
+        std::function<void(size_t, size_t)> fn;
+    };
+    auto range = std::make_shared<Range>();
+    range->count = count;
+    range->grain = grain;
+    range->chunks = chunks;
+    range->fn = fn;
+
+    auto run = [](Range &r) {
+        size_t chunk;
+        while ((chunk = r.next.fetch_add(1)) < r.chunks) {
+            size_t begin = chunk * r.grain;
+            r.fn(begin, std::min(r.count, begin + r.grain));
+            if (r.done.fetch_add(1) + 1 == r.chunks)
+                r.done.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        push([range, run] { run(*range); });
+    run(*range);
+
+    for (size_t done; (done = range->done.load()) < chunks;)
+        range->done.wait(done);
+}
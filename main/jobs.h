@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * \brief Fixed pool of worker threads, one per core minus the main thread. Used for CPU work that
+ * has to stay off the GL thread, like image decoding. Nothing submitted here may touch GL.
+ */
+class JobSystem {
+  private:
+    std::vector<std::jthread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void push(std::function<void()> job);
+    void work();
+
+  public:
+    static JobSystem &get() {
+        static JobSystem instance;
+        return instance;
+    }
+
+    /**
+     * \brief Runs `fn` on a worker, the future carries its result or exception.
+     */
+    template <typename F> auto submit(F &&fn) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        // std::function needs a copyable callable, packaged_task isn't
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        auto future = task->get_future();
+        push([task]() { (*task)(); });
+        return future;
+    }
+
+    /**
+     * \brief Calls fn(begin, end) over [0, count) in chunks of `grain`, spread over the workers
+     * and the calling thread, and returns once every chunk is done. The caller takes chunks too,
+     * so nesting this inside a job can't deadlock. `fn` must not throw.
+     */
+    void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+    size_t worker_count() const { return workers.size(); }
+
+    ~JobSystem();
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+  private:
+    JobSystem();
+};
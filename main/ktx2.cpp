@@ -0,0 +1,263 @@
+#include "ktx2.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+static constexpr std::array<uint8_t, 12> IDENTIFIER = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                                       0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+// identifier, 9 header words, then dfd/kvd offsets as u32 pairs and sgd as a u64 pair
+static constexpr size_t HEADER_SIZE = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+static constexpr size_t LEVEL_ENTRY_SIZE = 3 * 8;
+
+bool vk_format_is_compressed(VkFormat f) {
+    switch (f) {
+    case VkFormat::bc1_rgb_unorm:
+    case VkFormat::bc1_rgb_srgb:
+    case VkFormat::bc3_unorm:
+    case VkFormat::bc3_srgb:
+    case VkFormat::bc7_unorm:
+    case VkFormat::bc7_srgb:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool vk_format_is_srgb(VkFormat f) {
+    switch (f) {
+    case VkFormat::r8g8b8a8_srgb:
+    case VkFormat::bc1_rgb_srgb:
+    case VkFormat::bc3_srgb:
+    case VkFormat::bc7_srgb:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t vk_format_block_bytes(VkFormat f) {
+    switch (f) {
+    case VkFormat::r8g8b8a8_unorm:
+    case VkFormat::r8g8b8a8_srgb:
+        return 4;
+    case VkFormat::bc1_rgb_unorm:
+    case VkFormat::bc1_rgb_srgb:
+        return 8;
+    case VkFormat::bc3_unorm:
+    case VkFormat::bc3_srgb:
+    case VkFormat::bc7_unorm:
+    case VkFormat::bc7_srgb:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t vk_format_level_size(VkFormat f, uint32_t width, uint32_t height) {
+    if (vk_format_is_compressed(f))
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * vk_format_block_bytes(f);
+    return size_t(width) * height * vk_format_block_bytes(f);
+}
+
+template <typename T> static T read(std::span<const std::byte> file, size_t offset) {
+    if (offset + sizeof(T) > file.size())
+        throw std::runtime_error("KTX2 file is truncated");
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    return value;
+}
+
+template <typename T> static void write(std::vector<std::byte> &out, size_t offset, T value) {
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+bool is_ktx2(std::span<const std::byte> file) {
+    return file.size() >= IDENTIFIER.size() &&
+           std::memcmp(file.data(), IDENTIFIER.data(), IDENTIFIER.size()) == 0;
+}
+
+Ktx2Image parse_ktx2(std::span<const std::byte> file) {
+    if (file.size() < HEADER_SIZE || !is_ktx2(file))
+        throw std::runtime_error("not a KTX2 file");
+
+    Ktx2Image img;
+    img.format = static_cast<VkFormat>(read<uint32_t>(file, 12));
+    img.width = read<uint32_t>(file, 20);
+    img.height = read<uint32_t>(file, 24);
+    auto depth = read<uint32_t>(file, 28);
+    auto layers = read<uint32_t>(file, 32);
+    auto faces = read<uint32_t>(file, 36);
+    auto levels = read<uint32_t>(file, 40);
+    auto supercompression = read<uint32_t>(file, 44);
+
+    if (img.width == 0 || img.height == 0)
+        throw std::runtime_error("KTX2 file has no pixels");
+    if (vk_format_block_bytes(img.format) == 0)
+        throw std::runtime_error("unsupported KTX2 format " +
+                                 std::to_string(static_cast<uint32_t>(img.format)));
+    if (depth > 1 || layers > 1 || faces != 1)
+        throw std::runtime_error("only single layer 2D KTX2 textures are supported");
+    if (supercompression != 0)
+        throw std::runtime_error("supercompressed KTX2 files are not supported");
+    // a level count of 0 asks the loader to generate mips, which is what this path avoids
+    if (levels == 0)
+        throw std::runtime_error("KTX2 file has no mip levels");
+    // checked before anything is sized by it, a bogus count would make reserve() throw bad_alloc
+    if (levels > static_cast<uint32_t>(std::bit_width(std::max(img.width, img.height))))
+        throw std::runtime_error("KTX2 file has more mip levels than its size allows");
+
+    img.levels.reserve(levels);
+    for (uint32_t i = 0; i < levels; ++i) {
+        size_t entry = HEADER_SIZE + i * LEVEL_ENTRY_SIZE;
+        auto offset = read<uint64_t>(file, entry);
+        auto length = read<uint64_t>(file, entry + 8);
+        auto w = std::max(1u, img.width >> i);
+        auto h = std::max(1u, img.height >> i);
+        // the compressed upload passes length as the image size, which GL wants exact
+        if (length != vk_format_level_size(img.format, w, h) || offset > file.size() ||
+            length > file.size() - offset)
+            throw std::runtime_error("KTX2 level " + std::to_string(i) + " is out of bounds");
+        img.levels.push_back(file.subspan(offset, length));
+    }
+    return img;
+}
+
+// Basic data format descriptor, required by the spec even though the loader only looks at
+// vkFormat.
+static std::vector<std::byte> make_dfd(VkFormat format) {
+    struct Sample {
+        uint16_t bitOffset;
+        uint8_t bitLength; // minus one
+        uint8_t channel;
+        uint32_t upper;
+    };
+    constexpr uint8_t LINEAR = 0x10; // alpha stays linear in sRGB formats
+
+    bool srgb = vk_format_is_srgb(format);
+    uint8_t model = 1; // RGBSDA
+    uint8_t blockDim = 0;
+    std::vector<Sample> samples;
+    switch (format) {
+    case VkFormat::r8g8b8a8_unorm:
+    case VkFormat::r8g8b8a8_srgb:
+        samples = {{0, 7, 0, 255},
+                   {8, 7, 1, 255},
+                   {16, 7, 2, 255},
+                   {24, 7, uint8_t(srgb ? 15 | LINEAR : 15), 255}};
+        break;
+    case VkFormat::bc1_rgb_unorm:
+    case VkFormat::bc1_rgb_srgb:
+        model = 128;
+        blockDim = 3;
+        samples = {{0, 63, 0, 0xFFFFFFFF}};
+        break;
+    case VkFormat::bc3_unorm:
+    case VkFormat::bc3_srgb:
+        model = 130;
+        blockDim = 3;
+        samples = {{0, 63, uint8_t(srgb ? 15 | LINEAR : 15), 0xFFFFFFFF},
+                   {64, 63, 0, 0xFFFFFFFF}};
+        break;
+    case VkFormat::bc7_unorm:
+    case VkFormat::bc7_srgb:
+        model = 134;
+        blockDim = 3;
+        samples = {{0, 127, 0, 0xFFFFFFFF}};
+        break;
+    default:
+        throw std::runtime_error("no data format descriptor for this format");
+    }
+
+    uint16_t blockSize = static_cast<uint16_t>(24 + 16 * samples.size());
+    std::vector<std::byte> dfd(4 + blockSize);
+    write<uint32_t>(dfd, 0, static_cast<uint32_t>(dfd.size()));
+    write<uint32_t>(dfd, 4, 0); // vendor Khronos, basic descriptor type
+    write<uint16_t>(dfd, 8, 2); // version
+    write<uint16_t>(dfd, 10, blockSize);
+    write<uint8_t>(dfd, 12, model);
+    write<uint8_t>(dfd, 13, 1);            // BT.709 primaries
+    write<uint8_t>(dfd, 14, srgb ? 2 : 1); // transfer function
+    write<uint8_t>(dfd, 15, 0);            // straight alpha
+    write<uint8_t>(dfd, 16, blockDim);
+    write<uint8_t>(dfd, 17, blockDim);
+    write<uint8_t>(dfd, 20, static_cast<uint8_t>(vk_format_block_bytes(format)));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        size_t at = 28 + i * 16;
+        write<uint16_t>(dfd, at, samples[i].bitOffset);
+        write<uint8_t>(dfd, at + 2, samples[i].bitLength);
+        write<uint8_t>(dfd, at + 3, samples[i].channel);
+        write<uint32_t>(dfd, at + 8, 0);
+        write<uint32_t>(dfd, at + 12, samples[i].upper);
+    }
+    return dfd;
+}
+
+static size_t align_up(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+std::vector<std::byte> write_ktx2(VkFormat format, uint32_t width, uint32_t height,
+                                  std::span<const std::vector<std::byte>> levels) {
+    if (levels.empty())
+        throw std::runtime_error("KTX2 needs at least one level");
+
+    auto dfd = make_dfd(format);
+    // key/value pairs sorted by key, each one NUL terminated key then NUL terminated value
+    using namespace std::string_view_literals;
+    constexpr std::array<std::string_view, 2> keyValues = {"KTXorientation\0ru\0"sv,
+                                                           "KTXwriter\0asset_tool\0"sv};
+    size_t kvdSize = 0;
+    for (auto kv : keyValues)
+        kvdSize += align_up(4 + kv.size(), 4);
+
+    size_t dfdOffset = HEADER_SIZE + levels.size() * LEVEL_ENTRY_SIZE;
+    size_t kvdOffset = dfdOffset + dfd.size();
+    size_t levelAlign = std::lcm<size_t>(vk_format_block_bytes(format), 4);
+
+    // level data goes smallest first, as the spec recommends for streaming
+    std::vector<size_t> offsets(levels.size());
+    size_t end = kvdOffset + kvdSize;
+    for (size_t i = levels.size(); i-- > 0;) {
+        offsets[i] = align_up(end, levelAlign);
+        end = offsets[i] + levels[i].size();
+    }
+
+    std::vector<std::byte> out(end);
+    std::memcpy(out.data(), IDENTIFIER.data(), IDENTIFIER.size());
+    write<uint32_t>(out, 12, static_cast<uint32_t>(format));
+    write<uint32_t>(out, 16, 1); // typeSize, bytes per component for plain formats
+    write<uint32_t>(out, 20, width);
+    write<uint32_t>(out, 24, height);
+    write<uint32_t>(out, 28, 0); // depth
+    write<uint32_t>(out, 32, 0); // layers
+    write<uint32_t>(out, 36, 1); // faces
+    write<uint32_t>(out, 40, static_cast<uint32_t>(levels.size()));
+    write<uint32_t>(out, 44, 0); // no supercompression
+    write<uint32_t>(out, 48, static_cast<uint32_t>(dfdOffset));
+    write<uint32_t>(out, 52, static_cast<uint32_t>(dfd.size()));
+    write<uint32_t>(out, 56, static_cast<uint32_t>(kvdOffset));
+    write<uint32_t>(out, 60, static_cast<uint32_t>(kvdSize));
+    write<uint64_t>(out, 64, 0);
+    write<uint64_t>(out, 72, 0);
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        size_t entry = HEADER_SIZE + i * LEVEL_ENTRY_SIZE;
+        write<uint64_t>(out, entry, offsets[i]);
+        write<uint64_t>(out, entry + 8, levels[i].size());
+        write<uint64_t>(out, entry + 16, levels[i].size());
+        std::memcpy(out.data() + offsets[i], levels[i].data(), levels[i].size());
+    }
+
+    std::memcpy(out.data() + dfdOffset, dfd.data(), dfd.size());
+    size_t kvAt = kvdOffset;
+    for (auto kv : keyValues) {
+        write<uint32_t>(out, kvAt, static_cast<uint32_t>(kv.size()));
+        std::memcpy(out.data() + kvAt + 4, kv.data(), kv.size());
+        kvAt += align_up(4 + kv.size(), 4);
+    }
+    return out;
+}
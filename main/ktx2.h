@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The handful of VkFormat values the loader and asset_tool know about. KTX2 stores Vulkan format
+// enums even for GL consumers, the mapping to GL formats lives in opengl_helpers/ktx_texture.hpp.
+enum class VkFormat : uint32_t {
+    undefined = 0,
+    r8g8b8a8_unorm = 37,
+    r8g8b8a8_srgb = 43,
+    bc1_rgb_unorm = 131,
+    bc1_rgb_srgb = 132,
+    bc3_unorm = 137,
+    bc3_srgb = 138,
+    bc7_unorm = 145,
+    bc7_srgb = 146,
+};
+
+bool vk_format_is_compressed(VkFormat f);
+bool vk_format_is_srgb(VkFormat f);
+// Bytes per texel for plain formats, per 4x4 block for compressed ones.
+uint32_t vk_format_block_bytes(VkFormat f);
+// Size of one mip level in bytes.
+size_t vk_format_level_size(VkFormat f, uint32_t width, uint32_t height);
+
+struct Ktx2Image {
+    VkFormat format = VkFormat::undefined;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // level 0 first, each span points into the buffer that was parsed
+    std::vector<std::span<const std::byte>> levels;
+};
+
+bool is_ktx2(std::span<const std::byte> file);
+
+/**
+ * \brief Parses a 2D, single layer, non-supercompressed KTX2 file. The returned levels reference
+ * `file` without copying, so it has to outlive them. Throws std::runtime_error on anything the
+ * loader doesn't support.
+ */
+Ktx2Image parse_ktx2(std::span<const std::byte> file);
+
+/**
+ * \brief Serializes `levels` (level 0 first) into a KTX2 file with a basic data format descriptor.
+ * Rows are expected bottom-up as GL wants them, the file is tagged KTXorientation=ru to match.
+ */
+std::vector<std::byte> write_ktx2(VkFormat format, uint32_t width, uint32_t height,
+                                  std::span<const std::vector<std::byte>> levels);
@@ -1,14 +1,33 @@
 #pragma once
 
 #include "main.h"
+#include "asset_pack.h"
+#include "benchmark.h"
 #include "config_manager.h"
 #include "context.h"
+#include "dynamic_resolution.h"
+#include "entities.h"
+#include "gl_debug.h"
 #include "graphics.h"
 #include "konfig/konfig.h"
 #include "module_registry.h"
+#include "post_process.h"
+#include "render_passes.h"
+#include "opengl_helpers/extensions.hpp"
+#include "opengl_helpers/frame_sync.hpp"
+#include "opengl_helpers/quad_batch.hpp"
+#include "opengl_helpers/render_target.hpp"
+#include "opengl_helpers/texture_manager.hpp"
+#include "opengl_helpers/texture_upload.hpp"
+#include "opengl_helpers/vertex_layout.hpp"
+#include "settings.h"
 #include "theme.h"
+#include "transforms.h"
 #include "window_utils.h"
 #include <boost/scope/defer.hpp>
+#include <chrono>
+#include <filesystem>
+#include <optional>
 #include <spdlog/spdlog.h>
 
 namespace l = spdlog;
@@ -39,7 +58,7 @@ std::string state_to_string(const State &s) {
                        f, fmt::join(kvs, ",\n\t\t"), s.saved.x, s.saved.y, s.saved.w, s.saved.h);
 };
 
-GLFWwindow *initGLFW() {
+GLFWwindow *initGLFW(GLProfile profile, bool visible) {
     if (glfwInit() != GLFW_TRUE)
         throw std::runtime_error("failed to initialize glfw");
     glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
@@ -47,8 +66,14 @@ GLFWwindow *initGLFW() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_OPENGL_COMPAT_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
-    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    // the debug context costs driver-side validation on every call, release skips all of it
+    if (profile == GLProfile::debug) {
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    } else {
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_NO_ERROR, GLFW_TRUE);
+    }
     glfwWindowHint(GLFW_REFRESH_RATE, GLFW_DONT_CARE);
     glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
     auto w = glfwCreateWindow(800, 600, "gabagool", NULL, NULL);
@@ -58,7 +83,8 @@ GLFWwindow *initGLFW() {
     }
     glfwMakeContextCurrent(w);
     glfwSwapInterval(1);
-    l::info("✓ glfw initialized, with version: {}", glfwGetVersionString());
+    l::info("✓ glfw initialized, with version: {}, GL profile: {}", glfwGetVersionString(),
+            gl_profile_to_string(profile));
 
     return w;
 }
@@ -93,7 +119,25 @@ ImGuiIO &initImGui(GLFWwindow *w) {
     return io;
 }
 
+using Clock = std::chrono::steady_clock;
+
+// A poll that takes longer than this is stuck in the OS's modal move/resize loop, which only
+// hands control back through callbacks.
+static constexpr std::chrono::milliseconds STALLED_POLL{16};
+
+// Where the main loop is, so the refresh callback can tell whether the loop's own frame is about
+// to cover the refresh.
+static struct {
+    bool in_frame = false;
+    Clock::time_point poll_start;
+    Clock::time_point last_frame;
+    std::shared_ptr<RenderTarget> last_image; // kept for blit refreshes
+} loop;
+
 void render_frame() {
+    loop.in_frame = true;
+    BOOST_SCOPE_DEFER[] { loop.in_frame = false; };
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ig::NewFrame();
@@ -104,13 +148,43 @@ void render_frame() {
     int display_w, display_h;
     glfwGetFramebufferSize(ctx->w, &display_w, &display_h);
     glViewport(0, 0, display_w, display_h);
-    glClearColor(ctx->clear_color.x * ctx->clear_color.w, ctx->clear_color.y * ctx->clear_color.w,
-                 ctx->clear_color.z * ctx->clear_color.w, ctx->clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    for (auto &pass : ctx->registry.render_passes)
-        pass();
+    auto frame = mngr->getSection<frame_config>("frame");
+    if (frame)
+        TextureUploadQueue::get().process(static_cast<size_t>(frame->data.upload_budget_kb) * 1024);
+    if (auto textures = mngr->getSection<texture_config>("textures"))
+        TextureManager::get().collect(static_cast<size_t>(textures->data.vram_budget_mb) << 20);
+    RenderTargetPool::get().collect();
+    ctx->entities->flush();
+    for (auto &system : ctx->registry.systems)
+        system();
+    ctx->transforms->update();
+    auto resolution = mngr->getSection<resolution_config>("resolution");
+    auto post = mngr->getSection<post_config>("post");
+    // post effects read the scene back, so it goes to a half-float target even at full scale
+    bool post_enabled = post && PostProcessChain::enabled(post->data);
+    auto scene = ctx->resolution->begin(display_w, display_h,
+                                        resolution ? resolution->data : resolution_config{},
+                                        post_enabled ? GL_RGBA16F : 0);
+    ctx->passes->run(ctx->registry.render_passes, scene.fbo, scene.width, scene.height,
+                     ctx->clear_color, frame && frame->data.cache_passes);
+    // quads are in window pixels, the scene target covers the window at any scale
+    ctx->quads->flush(display_w, display_h);
+    const RenderTarget *output = nullptr;
+    if (post_enabled && scene.target)
+        output = &ctx->post->run(*scene.target, post->data);
+    else
+        ctx->post->release();
+    // upscaled before the UI is drawn, so it stays at native resolution
+    ctx->resolution->end(output);
 
     ImGui_ImplOpenGL3_RenderDrawData(ig::GetDrawData());
+    if (frame && frame->data.blit_refresh && display_w > 0 && display_h > 0) {
+        RenderTargetPool::get().fit(loop.last_image, {display_w, display_h, GL_RGBA8, 0});
+        glBlitNamedFramebuffer(0, loop.last_image->get(), 0, 0, display_w, display_h, 0, 0,
+                               display_w, display_h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    } else {
+        loop.last_image.reset();
+    }
 
     if (ig::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
         auto backup_current_context = glfwGetCurrentContext();
@@ -120,10 +194,57 @@ void render_frame() {
     }
 
     glfwSwapBuffers(ctx->w);
+    if (ctx->frame_sync)
+        ctx->frame_sync->fence();
+    gl_debug_end_frame();
+    loop.last_frame = Clock::now();
 }
 
-void framebuffer_size_callback(GLFWwindow *window, int width, int height) { /* empty callback */ }
-void window_refresh_callback(GLFWwindow *window) { render_frame(); }
+// Stretches the last frame over the window, for when the window has to be redrawn and a new frame
+// is too expensive.
+void present_last_frame() {
+    int display_w, display_h;
+    glfwGetFramebufferSize(ctx->w, &display_w, &display_h);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, display_w, display_h);
+    glBlitNamedFramebuffer(loop.last_image->get(), 0, 0, 0, loop.last_image->width(),
+                           loop.last_image->height(), 0, 0, display_w, display_h,
+                           GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glfwSwapBuffers(ctx->w);
+    if (ctx->frame_sync)
+        ctx->frame_sync->fence();
+}
+
+// render targets follow the framebuffer size on their own, the pool only needs to know a resize is
+// in progress so it doesn't reallocate them on every step of a drag
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+    RenderTargetPool::get().notifyResize();
+}
+// Refreshes arrive from inside glfwPollEvents, usually right before the loop renders anyway, so
+// they only draw when polling is stuck in a modal resize loop. Even then at most one frame is
+// rendered per interval, however many resize and expose events come in.
+void window_refresh_callback(GLFWwindow *window) {
+    if (loop.in_frame)
+        return;
+    auto now = Clock::now();
+    if (now - loop.poll_start < STALLED_POLL) {
+        ctx->refreshes.coalesced++;
+        return;
+    }
+
+    auto frame = mngr->getSection<frame_config>("frame");
+    if (frame && frame->data.blit_refresh && loop.last_image) {
+        present_last_frame();
+        ctx->refreshes.blitted++;
+    } else if (now - loop.last_frame >= STALLED_POLL) {
+        if (ctx->frame_sync && frame)
+            ctx->frame_sync->wait(frame->data.frames_in_flight);
+        render_frame();
+        ctx->refreshes.rendered++;
+    } else {
+        ctx->refreshes.coalesced++;
+    }
+}
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
     if (action == GLFW_PRESS)
         ctx->key_map[key] = true;
@@ -137,8 +258,15 @@ bool is_key_pressed(int key) {
     return current && !previous;
 }
 
-int main() {
-    auto w = initGLFW();
+int main(int argc, char **argv) {
+    auto opts = parse_launch_options(argc, argv);
+    // CPU only, so no window or GL context is needed
+    if (opts.microbench) {
+        run_benchmarks(opts.microbench_filter);
+        return 0;
+    }
+
+    auto w = initGLFW(opts.profile, !opts.hidden);
     BOOST_SCOPE_DEFER[&w] {
         glfwDestroyWindow(w);
         glfwTerminate();
@@ -150,6 +278,9 @@ int main() {
     l::debug("OpenGL Version: {}", (const char *)glGetString(GL_VERSION));
     l::debug("OpenGL Vendor: {}", (const char *)glGetString(GL_VENDOR));
     l::debug("OpenGL Renderer: {}", (const char *)glGetString(GL_RENDERER));
+    GLExtensions::get().load();
+    if (opts.profile == GLProfile::debug)
+        install_gl_debug_output();
 
     auto io = initImGui(w);
     BOOST_SCOPE_DEFER[] {
@@ -161,14 +292,61 @@ int main() {
 
     ctx = std::make_shared<State>();
     ctx->w = w;
+    ctx->gl_profile = opts.profile;
     ctx->clear_color = ImVec4(0.01f, 0.01f, 0.01f, 1.0f);
 
     mngr = std::make_shared<ConfigManager>("config.toml");
 
+    // built by `asset_tool pack`, loose files under assets/ are still used for anything not in it
+    if (std::filesystem::exists("assets.pak")) {
+        try {
+            auto pack = std::make_shared<AssetPack>("assets.pak");
+            l::info("✓ asset pack mounted: {} assets, {} KiB", pack->size(),
+                    pack->bytes() / 1024);
+            mount_asset_pack(std::move(pack));
+        } catch (const std::exception &e) {
+            l::error("{}", e.what());
+        }
+    }
+    auto frame_cfg = mngr->addSection<frame_config>("frame");
+    mngr->addSection<texture_config>("textures");
+    mngr->addSection<resolution_config>("resolution");
+    mngr->addSection<post_config>("post");
+    mngr->addSection<cubes_config>("cubes");
+    mngr->addSection<sprites_config>("sprites");
+
+    // declared after the glfw/imgui teardown so their GL objects are deleted while the context is
+    // still alive
+    FrameSync frame_sync;
+    ctx->frame_sync = &frame_sync;
+    RenderPassRunner passes;
+    ctx->passes = &passes;
+    DynamicResolution resolution;
+    ctx->resolution = &resolution;
+    PostProcessChain post;
+    ctx->post = &post;
+    TransformHierarchy transforms;
+    ctx->transforms = &transforms;
+    EntityStore entities;
+    ctx->entities = &entities;
+    QuadBatch quads;
+    ctx->quads = &quads;
+    // the loop state and these singletons are static, left alone their GL objects would be
+    // deleted after glfwTerminate
+    BOOST_SCOPE_DEFER[] {
+        loop.last_image.reset();
+        RenderTargetPool::get().clear();
+        TextureManager::get().clear();
+        TextureUploadQueue::get().shutdown();
+        VertexArrayCache::get().clear();
+    };
+
     INIT_ALL_MODULES(ctx->registry, *ctx);
     BOOST_SCOPE_DEFER[] {
         for (auto &fn : ctx->registry.cleanups)
             fn();
+        // ctx outlives main, so whatever the callbacks hold would otherwise go with it
+        ctx->registry = {};
         l::info("all modules cleaned up");
     };
 
@@ -177,8 +355,26 @@ int main() {
     glfwSetWindowRefreshCallback(w, window_refresh_callback);
     glfwSetKeyCallback(w, key_callback);
 
+    std::optional<FrameBenchmark> bench;
+    if (opts.bench_frames > 0) {
+        // measure the frames themselves, not the vsync wait
+        glfwSwapInterval(0);
+        bench.emplace(opts.bench_frames, opts.bench_csv);
+    }
+
     while (!glfwWindowShouldClose(w)) {
-        glfwPollEvents();
+        // with jit input the GPU wait happens before polling, so the frame is built from the
+        // freshest input instead of input that went stale while the CPU was blocked
+        if (frame_cfg->data.jit_input) {
+            frame_sync.wait(frame_cfg->data.frames_in_flight);
+            loop.poll_start = Clock::now();
+            glfwPollEvents();
+        } else {
+            loop.poll_start = Clock::now();
+            glfwPollEvents();
+            frame_sync.wait(frame_cfg->data.frames_in_flight);
+        }
+        ctx->frame_wait_ms = frame_sync.waitMs();
 
         if (glfwGetKey(w, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(w, GLFW_TRUE);
@@ -205,7 +401,16 @@ int main() {
             }
         }
 
+        if (bench)
+            bench->begin_frame();
         render_frame();
+        if (bench) {
+            bench->end_frame();
+            if (bench->done()) {
+                bench->report(ctx->gl_profile);
+                glfwSetWindowShouldClose(w, GLFW_TRUE);
+            }
+        }
         ctx->prev_key_map = ctx->key_map;
 
         // doesn't really work with hot reload but it can still rebuild shaders
@@ -215,6 +420,10 @@ int main() {
             ctx->registry.ui_panels.clear();
             ctx->registry.render_passes.clear();
             ctx->registry.cleanups.clear();
+            ctx->registry.systems.clear();
+            passes.invalidate();
+            // modules rebuild their programs, which can come back under the same GL names
+            quads.invalidatePrograms();
             INIT_ALL_MODULES(ctx->registry, *ctx);
             ctx->queue_reload = false;
             l::info("all modules reloaded");
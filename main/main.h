@@ -1,6 +1,8 @@
 #pragma once
 
+#include "gl_debug.h"
 #include "graphics.h"
+#include <algorithm>
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 #include <functional>
@@ -11,18 +13,49 @@
 
 using std::vector;
 
+class FrameSync;
+class RenderPassRunner;
+class DynamicResolution;
+class PostProcessChain;
+class TransformHierarchy;
+class EntityStore;
+class QuadBatch;
+
+/**
+ * \brief A render pass. Passes that can say what their output depends on set `inputs`, which
+ * returns a hash of it (textures, uniforms, ...) or 0 while not ready to draw. Cacheable passes at
+ * the start of the frame are rendered once and replayed until their inputs or the framebuffer
+ * size change.
+ */
+struct RenderPass {
+    std::function<void()> draw;
+    std::function<uint64_t()> inputs;
+    bool opaque = false; // covers every pixel once drawn, so the color clear before it is skipped
+    int order = 0;       // passes draw in ascending order, ties in the order they were added
+};
+
 struct Registry {
-    using RenderPass = std::function<void()>;
     using UIPanel = std::function<void()>;
     using CleanupFn = std::function<void()>;
+    // per frame update, runs after State::entities is flushed and before the render passes
+    using SystemFn = std::function<void()>;
 
     vector<RenderPass> render_passes;
     vector<UIPanel> ui_panels;
     vector<CleanupFn> cleanups;
+    vector<SystemFn> systems;
 
-    void add_render_pass(RenderPass cb) { render_passes.emplace_back(std::move(cb)); }
+    void add_render_pass(std::function<void()> cb) {
+        add_render_pass(RenderPass{.draw = std::move(cb)});
+    }
+    void add_render_pass(RenderPass pass) {
+        auto at = std::upper_bound(render_passes.begin(), render_passes.end(), pass.order,
+                                   [](int order, const RenderPass &p) { return order < p.order; });
+        render_passes.insert(at, std::move(pass));
+    }
     void add_ui_panel(UIPanel cb) { ui_panels.emplace_back(std::move(cb)); }
     void add_cleanup(CleanupFn cb) { cleanups.emplace_back(std::move(cb)); }
+    void add_system(SystemFn cb) { systems.emplace_back(std::move(cb)); }
 };
 
 enum Fullscreen {
@@ -36,6 +69,14 @@ struct State {
     ImVec4 clear_color;
     Registry registry;
     Fullscreen fullscreen;
+    GLProfile gl_profile;
+    FrameSync *frame_sync = nullptr;          // owned by main, fenced after every swap
+    RenderPassRunner *passes = nullptr;       // owned by main, runs registry.render_passes
+    DynamicResolution *resolution = nullptr;  // owned by main, sizes the target passes draw into
+    PostProcessChain *post = nullptr;         // owned by main, runs between passes and the UI
+    TransformHierarchy *transforms = nullptr; // owned by main, updated before the passes run
+    EntityStore *entities = nullptr;          // owned by main, flushed at the start of a frame
+    QuadBatch *quads = nullptr;               // owned by main, drawn after the render passes
     std::unordered_map<int, bool> key_map;
     std::unordered_map<int, bool> prev_key_map;
     struct { // used for saving size and position
@@ -43,6 +84,12 @@ struct State {
     } saved;
     bool display_debug = false;
     bool queue_reload = false;
+    double frame_wait_ms = 0.0; // time the CPU last spent waiting on frames in flight
+    struct { // window refresh events, most are covered by the loop's next frame
+        size_t coalesced = 0;
+        size_t rendered = 0;
+        size_t blitted = 0;
+    } refreshes;
 };
 
 constexpr std::string fullscreen_to_string(Fullscreen f);
@@ -0,0 +1,20 @@
+#include "math_kernels_impl.h"
+#include <algorithm>
+
+static const MathKernels &math_kernels_scalar() {
+    static const MathKernels kernels = make_math_kernels<ScalarV>(SimdLevel::scalar);
+    return kernels;
+}
+
+const MathKernels &math_kernels(SimdLevel level) {
+    level = std::min(level, best_simd_level());
+#if CPU_X86
+    if (level == SimdLevel::avx512)
+        return math_kernels_avx512();
+    if (level == SimdLevel::avx2)
+        return math_kernels_avx2();
+    if (level == SimdLevel::sse41)
+        return math_kernels_sse41();
+#endif
+    return math_kernels_scalar();
+}
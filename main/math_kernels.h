@@ -0,0 +1,126 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "graphics.h"
+#include <cstddef>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+// Batched math over glm types stored as structure of arrays: every component of every element
+// has its own array, so a SIMD lane works on one element and the kernels need no shuffles.
+// Outputs must not overlap the inputs.
+
+// Column c, row r at m[c * 4 + r], the order glm stores a mat4 in.
+struct Mat4SoA {
+    float *m[16];
+};
+
+struct Vec3SoA {
+    float *x, *y, *z;
+};
+
+struct QuatSoA {
+    float *x, *y, *z, *w;
+};
+
+struct AabbSoA {
+    Vec3SoA min, max;
+};
+
+/**
+ * \brief One implementation of every kernel, each processes elements [0, count).
+ */
+struct MathKernels {
+    SimdLevel level;
+    // out = a * b
+    void (*mat_mul)(const Mat4SoA &a, const Mat4SoA &b, const Mat4SoA &out, size_t count);
+    // out = (m * vec4(p, 1)).xyz, the bottom row is ignored so m has to be affine
+    void (*transform_points)(const Mat4SoA &m, const Vec3SoA &p, const Vec3SoA &out,
+                             size_t count);
+    // Bounds of the transformed box, from its transformed center and the absolute values of the
+    // upper 3x3 applied to its half extents, which is exact for affine m.
+    void (*transform_aabbs)(const Mat4SoA &m, const AabbSoA &box, const AabbSoA &out,
+                            size_t count);
+    // Rotation matrices of unit quaternions, with no translation.
+    void (*quat_to_mat)(const QuatSoA &q, const Mat4SoA &out, size_t count);
+};
+
+// Kernels for `level`, or the best this CPU runs when `level` isn't supported.
+const MathKernels &math_kernels(SimdLevel level = best_simd_level());
+
+/**
+ * \brief Owns N float arrays of the same length, back to back in one allocation. The typed
+ * wrappers below build kernel views over it and convert single elements from and to glm.
+ */
+template <size_t N> class SoAArrays {
+  private:
+    std::vector<float> data;
+    size_t count;
+
+  public:
+    explicit SoAArrays(size_t count = 0) : data(N * count), count(count) {}
+
+    float *operator[](size_t component) { return data.data() + component * count; }
+    const float *operator[](size_t component) const { return data.data() + component * count; }
+    size_t size() const { return count; }
+};
+
+struct Mat4Array : SoAArrays<16> {
+    using SoAArrays::SoAArrays;
+
+    Mat4SoA view() {
+        Mat4SoA v;
+        for (size_t k = 0; k < 16; ++k)
+            v.m[k] = (*this)[k];
+        return v;
+    }
+    void set(size_t i, const glm::mat4 &m) {
+        for (size_t k = 0; k < 16; ++k)
+            (*this)[k][i] = m[k / 4][k % 4];
+    }
+    glm::mat4 get(size_t i) const {
+        glm::mat4 m;
+        for (size_t k = 0; k < 16; ++k)
+            m[k / 4][k % 4] = (*this)[k][i];
+        return m;
+    }
+};
+
+struct Vec3Array : SoAArrays<3> {
+    using SoAArrays::SoAArrays;
+
+    Vec3SoA view() { return {(*this)[0], (*this)[1], (*this)[2]}; }
+    void set(size_t i, const glm::vec3 &v) {
+        for (size_t k = 0; k < 3; ++k)
+            (*this)[k][i] = v[k];
+    }
+    glm::vec3 get(size_t i) const { return {(*this)[0][i], (*this)[1][i], (*this)[2][i]}; }
+};
+
+struct QuatArray : SoAArrays<4> {
+    using SoAArrays::SoAArrays;
+
+    QuatSoA view() { return {(*this)[0], (*this)[1], (*this)[2], (*this)[3]}; }
+    void set(size_t i, const glm::quat &q) {
+        (*this)[0][i] = q.x;
+        (*this)[1][i] = q.y;
+        (*this)[2][i] = q.z;
+        (*this)[3][i] = q.w;
+    }
+};
+
+struct AabbArray : SoAArrays<6> {
+    using SoAArrays::SoAArrays;
+
+    AabbSoA view() {
+        return {{(*this)[0], (*this)[1], (*this)[2]}, {(*this)[3], (*this)[4], (*this)[5]}};
+    }
+    void set(size_t i, const glm::vec3 &min, const glm::vec3 &max) {
+        for (size_t k = 0; k < 3; ++k) {
+            (*this)[k][i] = min[k];
+            (*this)[3 + k][i] = max[k];
+        }
+    }
+    glm::vec3 min(size_t i) const { return {(*this)[0][i], (*this)[1][i], (*this)[2][i]}; }
+    glm::vec3 max(size_t i) const { return {(*this)[3][i], (*this)[4][i], (*this)[5][i]}; }
+};
@@ -0,0 +1,39 @@
+#include "math_kernels.h"
+
+#if CPU_X86
+// includes stay above the target switch, see math_kernels_sse41.cpp
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include "math_kernels_impl.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2V {
+    using T = __m256;
+    static constexpr size_t width = 8;
+    static T load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, T v) { _mm256_storeu_ps(p, v); }
+    static T set1(float v) { return _mm256_set1_ps(v); }
+    static T add(T a, T b) { return _mm256_add_ps(a, b); }
+    static T sub(T a, T b) { return _mm256_sub_ps(a, b); }
+    static T mul(T a, T b) { return _mm256_mul_ps(a, b); }
+    static T fma(T a, T b, T c) { return _mm256_fmadd_ps(a, b, c); }
+    static T abs(T a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+};
+
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const MathKernels &math_kernels_avx2() {
+    static const MathKernels kernels = make_math_kernels<Avx2V>(SimdLevel::avx2);
+    return kernels;
+}
+#endif
@@ -0,0 +1,40 @@
+#include "math_kernels.h"
+
+#if CPU_X86
+// includes stay above the target switch, see math_kernels_sse41.cpp
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f,avx512dq,avx512vl,avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512dq,avx512vl,avx2,fma"))),    \
+                             apply_to = function)
+#endif
+
+#include "math_kernels_impl.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Avx512V {
+    using T = __m512;
+    static constexpr size_t width = 16;
+    static T load(const float *p) { return _mm512_loadu_ps(p); }
+    static void store(float *p, T v) { _mm512_storeu_ps(p, v); }
+    static T set1(float v) { return _mm512_set1_ps(v); }
+    static T add(T a, T b) { return _mm512_add_ps(a, b); }
+    static T sub(T a, T b) { return _mm512_sub_ps(a, b); }
+    static T mul(T a, T b) { return _mm512_mul_ps(a, b); }
+    static T fma(T a, T b, T c) { return _mm512_fmadd_ps(a, b, c); }
+    static T abs(T a) { return _mm512_abs_ps(a); }
+};
+
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const MathKernels &math_kernels_avx512() {
+    static const MathKernels kernels = make_math_kernels<Avx512V>(SimdLevel::avx512);
+    return kernels;
+}
+#endif
@@ -0,0 +1,152 @@
+#pragma once
+
+// Shared by the math_kernels*.cpp files, everything else goes through math_kernels.h. Every
+// kernel is written once against a small vector type V with `width` lanes, each file includes
+// this after its target switch and instantiates it with its own V. The anonymous namespace keeps
+// those instantiations, the scalar tails included, from being merged across files compiled for
+// different instruction sets.
+
+#include "math_kernels.h"
+
+namespace {
+
+// One lane, for the scalar kernels and for the tails of the SIMD ones.
+struct ScalarV {
+    using T = float;
+    static constexpr size_t width = 1;
+    static T load(const float *p) { return *p; }
+    static void store(float *p, T v) { *p = v; }
+    static T set1(float v) { return v; }
+    static T add(T a, T b) { return a + b; }
+    static T sub(T a, T b) { return a - b; }
+    static T mul(T a, T b) { return a * b; }
+    static T fma(T a, T b, T c) { return a * b + c; }
+    static T abs(T a) { return a < 0.0f ? -a : a; }
+};
+
+template <typename V> size_t mat_mul_block(const Mat4SoA &a, const Mat4SoA &b, const Mat4SoA &out,
+                                           size_t i, size_t count) {
+    for (; i + V::width <= count; i += V::width) {
+        for (int c = 0; c < 4; ++c) {
+            typename V::T b0 = V::load(b.m[c * 4] + i), b1 = V::load(b.m[c * 4 + 1] + i);
+            typename V::T b2 = V::load(b.m[c * 4 + 2] + i), b3 = V::load(b.m[c * 4 + 3] + i);
+            for (int r = 0; r < 4; ++r) {
+                auto v = V::mul(V::load(a.m[r] + i), b0);
+                v = V::fma(V::load(a.m[4 + r] + i), b1, v);
+                v = V::fma(V::load(a.m[8 + r] + i), b2, v);
+                v = V::fma(V::load(a.m[12 + r] + i), b3, v);
+                V::store(out.m[c * 4 + r] + i, v);
+            }
+        }
+    }
+    return i;
+}
+
+template <typename V>
+size_t transform_points_block(const Mat4SoA &m, const Vec3SoA &p, const Vec3SoA &out, size_t i,
+                              size_t count) {
+    float *dst[3] = {out.x, out.y, out.z};
+    for (; i + V::width <= count; i += V::width) {
+        auto x = V::load(p.x + i), y = V::load(p.y + i), z = V::load(p.z + i);
+        for (int r = 0; r < 3; ++r) {
+            auto v = V::fma(V::load(m.m[r] + i), x, V::load(m.m[12 + r] + i));
+            v = V::fma(V::load(m.m[4 + r] + i), y, v);
+            v = V::fma(V::load(m.m[8 + r] + i), z, v);
+            V::store(dst[r] + i, v);
+        }
+    }
+    return i;
+}
+
+template <typename V>
+size_t transform_aabbs_block(const Mat4SoA &m, const AabbSoA &box, const AabbSoA &out, size_t i,
+                             size_t count) {
+    const float *lo[3] = {box.min.x, box.min.y, box.min.z};
+    const float *hi[3] = {box.max.x, box.max.y, box.max.z};
+    float *out_lo[3] = {out.min.x, out.min.y, out.min.z};
+    float *out_hi[3] = {out.max.x, out.max.y, out.max.z};
+    const auto half = V::set1(0.5f);
+    for (; i + V::width <= count; i += V::width) {
+        typename V::T center[3], extent[3];
+        for (int k = 0; k < 3; ++k) {
+            auto a = V::load(lo[k] + i), b = V::load(hi[k] + i);
+            center[k] = V::mul(V::add(a, b), half);
+            extent[k] = V::mul(V::sub(b, a), half);
+        }
+        for (int r = 0; r < 3; ++r) {
+            auto c = V::load(m.m[12 + r] + i);
+            auto e = V::set1(0.0f);
+            for (int k = 0; k < 3; ++k) {
+                auto mk = V::load(m.m[k * 4 + r] + i);
+                c = V::fma(mk, center[k], c);
+                e = V::fma(V::abs(mk), extent[k], e);
+            }
+            V::store(out_lo[r] + i, V::sub(c, e));
+            V::store(out_hi[r] + i, V::add(c, e));
+        }
+    }
+    return i;
+}
+
+template <typename V>
+size_t quat_to_mat_block(const QuatSoA &q, const Mat4SoA &out, size_t i, size_t count) {
+    const auto one = V::set1(1.0f), two = V::set1(2.0f), zero = V::set1(0.0f);
+    for (; i + V::width <= count; i += V::width) {
+        auto x = V::load(q.x + i), y = V::load(q.y + i), z = V::load(q.z + i);
+        auto w = V::load(q.w + i);
+        auto x2 = V::mul(x, two), y2 = V::mul(y, two), z2 = V::mul(z, two);
+        auto xx = V::mul(x, x2), yy = V::mul(y, y2), zz = V::mul(z, z2);
+        auto xy = V::mul(x, y2), xz = V::mul(x, z2), yz = V::mul(y, z2);
+        auto wx = V::mul(w, x2), wy = V::mul(w, y2), wz = V::mul(w, z2);
+        const typename V::T values[16] = {
+            V::sub(one, V::add(yy, zz)), V::add(xy, wz), V::sub(xz, wy), zero,
+            V::sub(xy, wz), V::sub(one, V::add(xx, zz)), V::add(yz, wx), zero,
+            V::add(xz, wy), V::sub(yz, wx), V::sub(one, V::add(xx, yy)), zero,
+            zero, zero, zero, one,
+        };
+        for (int k = 0; k < 16; ++k)
+            V::store(out.m[k] + i, values[k]);
+    }
+    return i;
+}
+
+// Full kernels: the widest blocks V fits, then the rest one element at a time.
+
+template <typename V>
+void mat_mul(const Mat4SoA &a, const Mat4SoA &b, const Mat4SoA &out, size_t count) {
+    mat_mul_block<ScalarV>(a, b, out, mat_mul_block<V>(a, b, out, 0, count), count);
+}
+
+template <typename V>
+void transform_points(const Mat4SoA &m, const Vec3SoA &p, const Vec3SoA &out, size_t count) {
+    transform_points_block<ScalarV>(m, p, out, transform_points_block<V>(m, p, out, 0, count),
+                                    count);
+}
+
+template <typename V>
+void transform_aabbs(const Mat4SoA &m, const AabbSoA &box, const AabbSoA &out, size_t count) {
+    transform_aabbs_block<ScalarV>(m, box, out, transform_aabbs_block<V>(m, box, out, 0, count),
+                                   count);
+}
+
+template <typename V> void quat_to_mat(const QuatSoA &q, const Mat4SoA &out, size_t count) {
+    quat_to_mat_block<ScalarV>(q, out, quat_to_mat_block<V>(q, out, 0, count), count);
+}
+
+template <typename V> MathKernels make_math_kernels(SimdLevel level) {
+    return {
+        .level = level,
+        .mat_mul = mat_mul<V>,
+        .transform_points = transform_points<V>,
+        .transform_aabbs = transform_aabbs<V>,
+        .quat_to_mat = quat_to_mat<V>,
+    };
+}
+
+} // namespace
+
+#if CPU_X86
+const MathKernels &math_kernels_sse41();
+const MathKernels &math_kernels_avx2();
+const MathKernels &math_kernels_avx512();
+#endif
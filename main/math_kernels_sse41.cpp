@@ -0,0 +1,41 @@
+#include "math_kernels.h"
+
+#if CPU_X86
+// includes stay above the target switch, see image_kernels_avx2.cpp. The kernels themselves come
+// from math_kernels_impl.h, which has to be below it.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("sse4.1")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#endif
+
+#include "math_kernels_impl.h"
+#include <immintrin.h>
+
+namespace {
+
+// no FMA before AVX2, a separate multiply and add
+struct Sse41V {
+    using T = __m128;
+    static constexpr size_t width = 4;
+    static T load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, T v) { _mm_storeu_ps(p, v); }
+    static T set1(float v) { return _mm_set1_ps(v); }
+    static T add(T a, T b) { return _mm_add_ps(a, b); }
+    static T sub(T a, T b) { return _mm_sub_ps(a, b); }
+    static T mul(T a, T b) { return _mm_mul_ps(a, b); }
+    static T fma(T a, T b, T c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static T abs(T a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+};
+
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const MathKernels &math_kernels_sse41() {
+    static const MathKernels kernels = make_math_kernels<Sse41V>(SimdLevel::sse41);
+    return kernels;
+}
+#endif
@@ -14,6 +14,16 @@ template <typename T> class GLBuffer {
         glNamedBufferStorage(id, data.size_bytes(), data.data(), flags);
     }
 
+    // Immutable storage for `count` elements without initial contents.
+    void allocate(size_t count, GLbitfield flags = 0) {
+        glNamedBufferStorage(id, count * sizeof(T), nullptr, flags);
+    }
+
+    // Needs GL_DYNAMIC_STORAGE_BIT, offset is in elements.
+    void update(std::span<const T> data, size_t offset = 0) {
+        glNamedBufferSubData(id, offset * sizeof(T), data.size_bytes(), data.data());
+    }
+
     ~GLBuffer() { glDeleteBuffers(1, &id); }
 
     GLuint get() const { return id; }
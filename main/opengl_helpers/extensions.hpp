@@ -0,0 +1,62 @@
+#pragma once
+#include "../graphics.h"
+#include <spdlog/spdlog.h>
+
+// glad is generated for plain 4.5 core, so anything newer or optional is loaded here by hand.
+
+#ifndef GL_PARAMETER_BUFFER
+#define GL_PARAMETER_BUFFER 0x80EE
+#endif
+
+// GL_EXT_texture_compression_s3tc and its sRGB counterpart from GL_EXT_texture_sRGB
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+typedef void(GLAD_API_PTR *PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)(GLenum mode, GLenum type,
+                                                                    const void *indirect,
+                                                                    GLintptr drawcount,
+                                                                    GLsizei maxdrawcount,
+                                                                    GLsizei stride);
+
+struct GLExtensions {
+    // core in 4.6, otherwise GL_ARB_indirect_parameters
+    PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC multiDrawElementsIndirectCount = nullptr;
+    // BC1/BC3 textures, BC7 is core since 4.2
+    bool textureCompressionS3TC = false;
+
+    static GLExtensions &get() {
+        static GLExtensions instance;
+        return instance;
+    }
+
+    /**
+     * \brief Resolves optional entry points, has to run after glad with a current context.
+     */
+    void load() {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+        using IndirectCountFn = PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC;
+        if (major > 4 || (major == 4 && minor >= 6)) {
+            multiDrawElementsIndirectCount = reinterpret_cast<IndirectCountFn>(
+                glfwGetProcAddress("glMultiDrawElementsIndirectCount"));
+        } else if (glfwExtensionSupported("GL_ARB_indirect_parameters")) {
+            multiDrawElementsIndirectCount = reinterpret_cast<IndirectCountFn>(
+                glfwGetProcAddress("glMultiDrawElementsIndirectCountARB"));
+        }
+
+        textureCompressionS3TC = glfwExtensionSupported("GL_EXT_texture_compression_s3tc");
+
+        spdlog::info("✓ GL extensions loaded, indirect count: {}, s3tc: {}",
+                     multiDrawElementsIndirectCount ? "yes" : "no",
+                     textureCompressionS3TC ? "yes" : "no");
+    }
+
+  private:
+    GLExtensions() = default;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "../graphics.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+/**
+ * \brief Bounds how many frames the CPU may queue ahead of the GPU. A fence goes in after every
+ * swap, and before starting a new frame the CPU waits on the fence from `framesInFlight` frames
+ * ago instead of letting the driver decide how deep the queue gets.
+ */
+class FrameSync {
+  public:
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+
+  private:
+    std::array<GLsync, MAX_FRAMES_IN_FLIGHT> fences{};
+    size_t frame = 0;
+    double lastWaitMs = 0.0;
+
+  public:
+    ~FrameSync() {
+        for (auto &fence : fences) {
+            if (fence)
+                glDeleteSync(fence);
+        }
+    }
+
+    /**
+     * \brief Blocks until at most framesInFlight - 1 earlier frames are still queued on the GPU.
+     */
+    void wait(int framesInFlight) {
+        framesInFlight = std::clamp(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
+        auto start = std::chrono::steady_clock::now();
+
+        // wait on every fence older than the allowed depth, oldest first
+        for (int back = MAX_FRAMES_IN_FLIGHT; back >= framesInFlight; --back) {
+            auto &fence = fences[(frame + MAX_FRAMES_IN_FLIGHT - back) % MAX_FRAMES_IN_FLIGHT];
+            if (!fence)
+                continue;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) ==
+                   GL_TIMEOUT_EXPIRED) {
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+        lastWaitMs = took.count();
+    }
+
+    // Call right after swapping buffers.
+    void fence() {
+        auto &slot = fences[frame % MAX_FRAMES_IN_FLIGHT];
+        if (slot)
+            glDeleteSync(slot);
+        slot = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame++;
+    }
+
+    // How long the last wait() blocked the CPU.
+    double waitMs() const { return lastWaitMs; }
+
+    FrameSync() = default;
+    FrameSync(const FrameSync &) = delete;
+    FrameSync &operator=(const FrameSync &) = delete;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include "program.hpp"
+#include "shader_manager.hpp"
+#include "vertex_layout.hpp"
+#include <memory>
+
+/**
+ * \brief Shared vertex stage for passes that cover the whole framebuffer. It draws one triangle
+ * big enough to contain the viewport, with corners generated from gl_VertexID, so there is no
+ * vertex buffer and no diagonal seam where a two-triangle quad shades helper pixels twice. Every
+ * pass binds the same empty VAO.
+ *
+ * The vertex shader outputs `vUV`, 0..1 across the viewport with the origin at the bottom left.
+ */
+class FullscreenPass {
+  public:
+    static constexpr const char *VERTEX_SHADER_SOURCE = R"(
+#version 450 core
+out vec2 vUV;
+
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0;
+    vUV = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+    // The cached vertex shader, to link with a pass's fragment shader.
+    static std::shared_ptr<GLShader> vertexShader() {
+        return ShaderManager::get().getShader("fullscreen_vertex", GL_VERTEX_SHADER,
+                                              VERTEX_SHADER_SOURCE);
+    }
+
+    // Links `fragmentShader` against the shared vertex stage.
+    static std::unique_ptr<GLProgram> makeProgram(const GLShader &fragmentShader) {
+        return std::make_unique<GLProgram>(*vertexShader(), fragmentShader);
+    }
+
+    // Draws the triangle with whatever program and bindings are current.
+    static void draw() {
+        // looked up every time rather than kept, the cache is emptied at shutdown
+        VertexArrayCache::get().acquire<>()->bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+};
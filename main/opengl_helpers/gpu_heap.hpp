@@ -0,0 +1,328 @@
+#pragma once
+#include "buffer.hpp"
+#include "vertex_array.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Best-fit range allocator over [0, capacity) units. Free ranges are indexed both by offset
+ * (to merge neighbours on free) and by size (to find the smallest range that fits).
+ */
+class OffsetAllocator {
+  public:
+    struct Stats {
+        uint32_t capacity = 0;
+        uint32_t used = 0;
+        uint32_t largestFree = 0;
+        uint32_t freeRanges = 0;
+        uint32_t allocations = 0;
+
+        // 0 when all free space is one range, approaching 1 as it gets shredded
+        float fragmentation() const {
+            uint32_t free = capacity - used;
+            return free == 0 ? 0.0f : 1.0f - static_cast<float>(largestFree) / free;
+        }
+    };
+
+  private:
+    uint32_t capacity;
+    uint32_t used = 0;
+    uint32_t allocations = 0;
+    std::map<uint32_t, uint32_t> freeByOffset;    // offset -> size
+    std::multimap<uint32_t, uint32_t> freeBySize; // size -> offset
+
+    void insertFree(uint32_t offset, uint32_t size) {
+        freeByOffset[offset] = size;
+        freeBySize.emplace(size, offset);
+    }
+
+    void eraseFree(std::map<uint32_t, uint32_t>::iterator it) {
+        auto [first, last] = freeBySize.equal_range(it->second);
+        for (auto s = first; s != last; ++s) {
+            if (s->second == it->first) {
+                freeBySize.erase(s);
+                break;
+            }
+        }
+        freeByOffset.erase(it);
+    }
+
+  public:
+    explicit OffsetAllocator(uint32_t capacity) : capacity(capacity) {
+        if (capacity > 0)
+            insertFree(0, capacity);
+    }
+
+    std::optional<uint32_t> allocate(uint32_t size) {
+        if (size == 0)
+            return std::nullopt;
+        auto fit = freeBySize.lower_bound(size);
+        if (fit == freeBySize.end())
+            return std::nullopt;
+
+        uint32_t offset = fit->second;
+        uint32_t rangeSize = fit->first;
+        eraseFree(freeByOffset.find(offset));
+        if (rangeSize > size)
+            insertFree(offset + size, rangeSize - size);
+
+        used += size;
+        allocations++;
+        return offset;
+    }
+
+    void free(uint32_t offset, uint32_t size) {
+        used -= size;
+        allocations--;
+
+        auto next = freeByOffset.lower_bound(offset);
+        if (next != freeByOffset.end() && offset + size == next->first) {
+            size += next->second;
+            eraseFree(next);
+        }
+        auto prev = freeByOffset.lower_bound(offset);
+        if (prev != freeByOffset.begin()) {
+            --prev;
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                eraseFree(prev);
+            }
+        }
+        insertFree(offset, size);
+    }
+
+    Stats stats() const {
+        return {capacity, used, freeBySize.empty() ? 0 : freeBySize.rbegin()->first,
+                static_cast<uint32_t>(freeByOffset.size()), allocations};
+    }
+};
+
+/**
+ * \brief One large immutable GL buffer carved into sub-allocations of T. Allocations are referred
+ * to by stable handles, their element offsets can move when the heap is defragmented or grown, so
+ * offsets should be looked up again whenever generation() changes.
+ */
+template <typename T> class GpuHeap {
+  public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID = UINT32_MAX;
+
+  private:
+    struct Slot {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        bool live = false;
+    };
+
+    std::unique_ptr<GLBuffer<T>> buffer;
+    OffsetAllocator allocator;
+    uint32_t capacity;
+    std::vector<Slot> slots;
+    std::vector<Handle> freeSlots;
+    uint32_t gen = 0;
+
+    const Slot &liveSlot(Handle h) const {
+        if (h >= slots.size() || !slots[h].live)
+            throw std::runtime_error("GpuHeap handle " + std::to_string(h) + " is not allocated");
+        return slots[h];
+    }
+
+    // Moves every live allocation to the front of a fresh buffer of newCapacity elements.
+    void relocate(uint32_t newCapacity) {
+        auto fresh = std::make_unique<GLBuffer<T>>();
+        fresh->allocate(newCapacity, GL_DYNAMIC_STORAGE_BIT);
+
+        std::vector<Handle> live;
+        for (Handle h = 0; h < slots.size(); ++h) {
+            if (slots[h].live)
+                live.push_back(h);
+        }
+        std::sort(live.begin(), live.end(),
+                  [this](Handle a, Handle b) { return slots[a].offset < slots[b].offset; });
+
+        OffsetAllocator packed(newCapacity);
+        uint32_t cursor = 0;
+        size_t i = 0;
+        while (i < live.size()) {
+            // copy runs that are already contiguous with one call
+            uint32_t srcStart = slots[live[i]].offset;
+            uint32_t dstStart = cursor;
+            uint32_t runEnd = srcStart;
+            for (; i < live.size() && slots[live[i]].offset == runEnd; ++i) {
+                auto &slot = slots[live[i]];
+                runEnd += slot.size;
+                slot.offset = cursor;
+                cursor += slot.size;
+                packed.allocate(slot.size);
+            }
+            glCopyNamedBufferSubData(buffer->get(), fresh->get(), srcStart * sizeof(T),
+                                     dstStart * sizeof(T), (runEnd - srcStart) * sizeof(T));
+        }
+
+        buffer = std::move(fresh);
+        allocator = std::move(packed);
+        capacity = newCapacity;
+        gen++;
+    }
+
+  public:
+    explicit GpuHeap(uint32_t capacity) : allocator(capacity), capacity(capacity) {
+        buffer = std::make_unique<GLBuffer<T>>();
+        buffer->allocate(capacity, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    /**
+     * \brief Allocates and uploads `data`. When no free range fits, the heap first defragments
+     * and then doubles in size if that still isn't enough.
+     */
+    Handle allocate(std::span<const T> data) {
+        if (data.empty())
+            throw std::runtime_error("GpuHeap allocations can't be empty");
+
+        auto size = static_cast<uint32_t>(data.size());
+        auto offset = allocator.allocate(size);
+        if (!offset) {
+            auto s = allocator.stats();
+            bool fitsCompacted = s.capacity - s.used >= size;
+            relocate(fitsCompacted ? capacity : std::max(capacity * 2, s.used + size));
+            offset = allocator.allocate(size);
+        }
+
+        Handle h;
+        if (!freeSlots.empty()) {
+            h = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            h = static_cast<Handle>(slots.size());
+            slots.emplace_back();
+        }
+        slots[h] = {*offset, size, true};
+        buffer->update(data, *offset);
+        return h;
+    }
+
+    void free(Handle h) {
+        if (h >= slots.size() || !slots[h].live)
+            return;
+        auto &slot = slots[h];
+        allocator.free(slot.offset, slot.size);
+        slot.live = false;
+        freeSlots.push_back(h);
+    }
+
+    // Compacts all allocations to the start of the heap, worth it once fragmentation builds up.
+    void defragment() { relocate(capacity); }
+
+    // Both throw std::runtime_error for a handle that was never allocated or already freed.
+    uint32_t offset(Handle h) const { return liveSlot(h).offset; }
+    uint32_t size(Handle h) const { return liveSlot(h).size; }
+    uint32_t generation() const { return gen; }
+    OffsetAllocator::Stats stats() const { return allocator.stats(); }
+    const GLBuffer<T> &get() const { return *buffer; }
+
+    GpuHeap(const GpuHeap &) = delete;
+    GpuHeap &operator=(const GpuHeap &) = delete;
+};
+
+/**
+ * \brief Offsets of a mesh inside a MeshHeap, in the shape indirect draw commands want them.
+ */
+struct MeshRange {
+    GLuint indexCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+};
+
+/**
+ * \brief Packs many meshes with the same vertex type into one shared vertex and one shared index
+ * buffer, so they can all be drawn from a single VAO through base vertex and first index offsets.
+ */
+template <typename V> class MeshHeap {
+  public:
+    using Handle = uint32_t;
+
+  private:
+    struct Mesh {
+        typename GpuHeap<V>::Handle vertices;
+        typename GpuHeap<GLuint>::Handle indices;
+        bool live = false;
+    };
+
+    GpuHeap<V> vertices;
+    GpuHeap<GLuint> indices;
+    std::vector<Mesh> meshes;
+    std::vector<Handle> freeMeshes;
+
+  public:
+    MeshHeap(uint32_t vertexCapacity, uint32_t indexCapacity)
+        : vertices(vertexCapacity), indices(indexCapacity) {}
+
+    Handle add(std::span<const V> vertexData, std::span<const GLuint> indexData) {
+        Mesh mesh{vertices.allocate(vertexData), 0, true};
+        try {
+            mesh.indices = indices.allocate(indexData);
+        } catch (...) {
+            vertices.free(mesh.vertices);
+            throw;
+        }
+        if (!freeMeshes.empty()) {
+            Handle h = freeMeshes.back();
+            freeMeshes.pop_back();
+            meshes[h] = mesh;
+            return h;
+        }
+        meshes.push_back(mesh);
+        return static_cast<Handle>(meshes.size() - 1);
+    }
+
+    void remove(Handle h) {
+        if (h >= meshes.size() || !meshes[h].live)
+            return;
+        vertices.free(meshes[h].vertices);
+        indices.free(meshes[h].indices);
+        meshes[h].live = false;
+        freeMeshes.push_back(h);
+    }
+
+    MeshRange range(Handle h) const {
+        if (h >= meshes.size() || !meshes[h].live)
+            throw std::runtime_error("MeshHeap handle " + std::to_string(h) + " is not live");
+        const auto &mesh = meshes[h];
+        return {indices.size(mesh.indices), indices.offset(mesh.indices),
+                static_cast<GLint>(vertices.offset(mesh.vertices))};
+    }
+
+    void defragment() {
+        vertices.defragment();
+        indices.defragment();
+    }
+
+    /**
+     * \brief Points a VAO at the shared buffers. Has to be redone when generation() changes,
+     * since growing or defragmenting replaces the underlying buffers.
+     */
+    void bind(GLVertexArray &vao, GLuint binding = 0) const {
+        vao.setVertexBuffer(vertices.get(), binding);
+        vao.setElementBuffer(indices.get());
+    }
+
+    // Expects the VAO from bind() to be bound.
+    void draw(Handle h, GLenum mode = GL_TRIANGLES) const {
+        auto r = range(h);
+        glDrawElementsBaseVertex(mode, r.indexCount, GL_UNSIGNED_INT,
+                                 reinterpret_cast<const void *>(r.firstIndex * sizeof(GLuint)),
+                                 r.baseVertex);
+    }
+
+    uint32_t generation() const { return vertices.generation() + indices.generation(); }
+    OffsetAllocator::Stats vertexStats() const { return vertices.stats(); }
+    OffsetAllocator::Stats indexStats() const { return indices.stats(); }
+};
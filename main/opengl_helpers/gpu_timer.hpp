@@ -0,0 +1,49 @@
+#pragma once
+#include "../graphics.h"
+#include <array>
+
+/**
+ * \brief Measures GPU time between begin() and end() with timestamp queries. Results are read
+ * LATENCY frames later without blocking, and since timestamps (unlike GL_TIME_ELAPSED) nest,
+ * timers can be freely placed inside each other.
+ */
+template <size_t LATENCY = 4> class GpuTimer {
+  private:
+    std::array<GLuint, LATENCY * 2> queries{};
+    std::array<bool, LATENCY> pending{};
+    size_t current = 0;
+    double lastMs = 0.0;
+
+  public:
+    GpuTimer() {
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(queries.size()), queries.data());
+    }
+    ~GpuTimer() { glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data()); }
+
+    void begin() {
+        // harvest whatever is in this slot from LATENCY frames ago before reusing it
+        if (pending[current]) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[current * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 start = 0, end = 0;
+                glGetQueryObjectui64v(queries[current * 2], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(queries[current * 2 + 1], GL_QUERY_RESULT, &end);
+                lastMs = static_cast<double>(end - start) / 1e6;
+            }
+        }
+        glQueryCounter(queries[current * 2], GL_TIMESTAMP);
+    }
+
+    void end() {
+        glQueryCounter(queries[current * 2 + 1], GL_TIMESTAMP);
+        pending[current] = true;
+        current = (current + 1) % LATENCY;
+    }
+
+    // Most recent finished measurement in milliseconds.
+    double ms() const { return lastMs; }
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+};
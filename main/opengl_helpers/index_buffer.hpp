@@ -0,0 +1,44 @@
+#pragma once
+#include "buffer.hpp"
+#include "vertex_array.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * \brief Element buffer that stores indices as 16-bit whenever every index fits, halving index
+ * bandwidth for small meshes, and falls back to 32-bit otherwise.
+ */
+class GLIndexBuffer {
+  private:
+    GLBuffer<std::byte> buffer;
+    GLenum indexType;
+    GLsizei indexCount;
+
+  public:
+    explicit GLIndexBuffer(std::span<const uint32_t> indices)
+        : indexCount(static_cast<GLsizei>(indices.size())) {
+        uint32_t highest = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+        if (highest <= UINT16_MAX) {
+            indexType = GL_UNSIGNED_SHORT;
+            std::vector<uint16_t> narrow(indices.begin(), indices.end());
+            buffer.store(std::as_bytes(std::span(narrow)));
+        } else {
+            indexType = GL_UNSIGNED_INT;
+            buffer.store(std::as_bytes(indices));
+        }
+    }
+
+    void attach(GLVertexArray &vao) const { vao.setElementBuffer(buffer); }
+
+    // Expects a VAO with this buffer attached to be bound.
+    void draw(GLenum mode = GL_TRIANGLES, GLsizei instances = 1) const {
+        glDrawElementsInstanced(mode, indexCount, indexType, nullptr, instances);
+    }
+
+    GLenum type() const { return indexType; }
+    GLsizei count() const { return indexCount; }
+    GLuint get() const { return buffer.get(); }
+};
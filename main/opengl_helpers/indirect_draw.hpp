@@ -0,0 +1,235 @@
+#pragma once
+#include "../frustum.h"
+#include "extensions.hpp"
+#include "program.hpp"
+#include "shader_manager.hpp"
+#include "vertex_array.hpp"
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Layout mandated by GL for glMultiDrawElementsIndirect*.
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/**
+ * \brief Per-object input for GPU culling, std430 compatible. The sphere is in world space,
+ * the rest describes the indexed range drawn for the object if it survives culling.
+ */
+struct CullObject {
+    glm::vec4 sphere; // center.xyz, radius
+    GLuint indexCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint pad = 0;
+};
+
+enum class CullFeatures : uint32_t {
+    // compacts visible draws with an atomic counter, needs an indirect count entry point
+    Compact = 1 << 0,
+};
+
+#define CULL_FEATURES(X) X(CullFeatures::Compact, "COMPACT")
+
+MAKE_SHADER_FEATURES(CullFeatures, CULL_FEATURES);
+
+/**
+ * \brief Frustum culls objects in a compute shader and draws the survivors with a single
+ * multi-draw-indirect call, the CPU never reads anything back. When an indirect count entry point
+ * is available the command list is compacted and drawn with glMultiDrawElementsIndirectCount,
+ * otherwise every object keeps its slot and culled ones get instanceCount = 0.
+ *
+ * Each draw's baseInstance is the object index. Vertex shaders get at it through an instanced
+ * integer attribute fed from objectIds(), see bindObjectIds().
+ */
+class GPUCulledDraw {
+  private:
+    static constexpr const char *CULL_SHADER_SOURCE = R"(
+#version 450 core
+layout(local_size_x = 64) in;
+
+struct CullObject {
+    vec4 sphere;
+    uint indexCount;
+    uint firstIndex;
+    int baseVertex;
+    uint pad;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects { CullObject objects[]; };
+layout(std430, binding = 1) writeonly buffer Commands { DrawCommand commands[]; };
+layout(std430, binding = 2) buffer DrawCount { uint drawCount; };
+
+uniform vec4 uPlanes[6];
+uniform uint uObjectCount;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uObjectCount)
+        return;
+
+    CullObject o = objects[i];
+    bool visible = true;
+    for (int p = 0; p < 6; ++p)
+        visible = visible && dot(uPlanes[p].xyz, o.sphere.xyz) + uPlanes[p].w >= -o.sphere.w;
+
+#ifdef COMPACT
+    if (!visible)
+        return;
+    uint slot = atomicAdd(drawCount, 1u);
+    commands[slot] = DrawCommand(o.indexCount, 1u, o.firstIndex, o.baseVertex, i);
+#else
+    commands[i] = DrawCommand(o.indexCount, visible ? 1u : 0u, o.firstIndex, o.baseVertex, i);
+#endif
+}
+)";
+
+    std::unique_ptr<GLProgram> program;
+    UniformHandle planesHandle;
+    UniformHandle countHandle;
+    bool compact;
+
+    std::unique_ptr<GLBuffer<CullObject>> objects;
+    std::unique_ptr<GLBuffer<DrawElementsIndirectCommand>> commands;
+    std::unique_ptr<GLBuffer<GLuint>> ids;
+    GLBuffer<GLuint> drawCount;
+    size_t objectCount = 0;
+    size_t capacity = 0;
+
+    void reserve(size_t count) {
+        if (count <= capacity)
+            return;
+        capacity = std::max<size_t>(count, capacity * 2);
+
+        objects = std::make_unique<GLBuffer<CullObject>>();
+        objects->allocate(capacity, GL_DYNAMIC_STORAGE_BIT);
+        commands = std::make_unique<GLBuffer<DrawElementsIndirectCommand>>();
+        commands->allocate(capacity);
+
+        std::vector<GLuint> sequence(capacity);
+        for (size_t i = 0; i < capacity; ++i)
+            sequence[i] = static_cast<GLuint>(i);
+        ids = std::make_unique<GLBuffer<GLuint>>();
+        ids->store(sequence);
+    }
+
+  public:
+    GPUCulledDraw() : compact(GLExtensions::get().multiDrawElementsIndirectCount != nullptr) {
+        auto key = ShaderVariantKey<CullFeatures>{}.with(CullFeatures::Compact, compact);
+        auto cs = ShaderManager::get().getVariant("gpu_cull_compute", GL_COMPUTE_SHADER,
+                                                  CULL_SHADER_SOURCE, key);
+        program = std::make_unique<GLProgram>(*cs);
+        planesHandle = program->uniform("uPlanes");
+        countHandle = program->uniform("uObjectCount");
+
+        const GLuint zero = 0;
+        drawCount.store(std::span<const GLuint>(&zero, 1), GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    /**
+     * \brief Uploads the cullable objects. Only needs to be called again when they change.
+     */
+    void setObjects(std::span<const CullObject> data) {
+        objectCount = data.size();
+        if (data.empty())
+            return;
+        reserve(data.size());
+        objects->update(data);
+    }
+
+    /**
+     * \brief Sets up an integer attribute with divisor 1 that yields the object index in the
+     * vertex shader (declare it as `in uint`).
+     */
+    void bindObjectIds(GLVertexArray &vao, GLuint attribIndex, GLuint binding) const {
+        vao.setVertexBuffer(*ids, binding);
+        glVertexArrayAttribIFormat(vao.get(), attribIndex, 1, GL_UNSIGNED_INT, 0);
+        glEnableVertexArrayAttrib(vao.get(), attribIndex);
+        vao.setAttribBinding(attribIndex, binding);
+        vao.setBindingDivisor(binding, 1);
+    }
+
+    // Object ids live in a buffer that is replaced when the object count grows, rebind after
+    // setObjects if the capacity may have changed. Doesn't exist before the first non-empty
+    // setObjects.
+    const GLBuffer<GLuint> &objectIds() const { return *ids; }
+
+    void cull(const glm::mat4 &viewProjection) {
+        if (objectCount == 0)
+            return;
+
+        auto planes = extract_frustum(viewProjection);
+        program->set(planesHandle, std::span<const glm::vec4>(planes));
+        program->set(countHandle, static_cast<GLuint>(objectCount));
+
+        glClearNamedBufferSubData(drawCount.get(), GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER,
+                                  GL_UNSIGNED_INT, nullptr);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objects->get());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commands->get());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, drawCount.get());
+        program->use();
+        glDispatchCompute(static_cast<GLuint>((objectCount + 63) / 64), 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /**
+     * \brief Draws everything that survived the last cull(). The caller binds the program and a
+     * VAO with the element buffer the objects index into.
+     */
+    void draw(GLenum indexType = GL_UNSIGNED_INT) const {
+        if (objectCount == 0)
+            return;
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->get());
+        if (compact) {
+            glBindBuffer(GL_PARAMETER_BUFFER, drawCount.get());
+            GLExtensions::get().multiDrawElementsIndirectCount(
+                GL_TRIANGLES, indexType, nullptr, 0, static_cast<GLsizei>(objectCount), 0);
+            glBindBuffer(GL_PARAMETER_BUFFER, 0);
+        } else {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr,
+                                        static_cast<GLsizei>(objectCount), 0);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    /**
+     * \brief Number of draws the last cull() kept. Reads the result back and stalls until the GPU
+     * is done, so it is only meant for validating the culling, never for regular frames.
+     */
+    size_t countVisible() const {
+        if (objectCount == 0)
+            return 0;
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        if (compact) {
+            GLuint count = 0;
+            glGetNamedBufferSubData(drawCount.get(), 0, sizeof(count), &count);
+            return count;
+        }
+        std::vector<DrawElementsIndirectCommand> list(objectCount);
+        glGetNamedBufferSubData(commands->get(), 0, list.size() * sizeof(list[0]), list.data());
+        return std::count_if(list.begin(), list.end(),
+                             [](const auto &c) { return c.instanceCount != 0; });
+    }
+
+    bool isCompacting() const { return compact; }
+    size_t size() const { return objectCount; }
+
+    GPUCulledDraw(const GPUCulledDraw &) = delete;
+    GPUCulledDraw &operator=(const GPUCulledDraw &) = delete;
+};
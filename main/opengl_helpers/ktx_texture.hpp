@@ -0,0 +1,104 @@
+#pragma once
+#include "../asset_pack.h"
+#include "../ktx2.h"
+#include "extensions.hpp"
+#include "texture.hpp"
+#include <optional>
+#include <string>
+
+struct KtxGLFormat {
+    GLenum internalFormat;
+    GLenum format; // pixel transfer format, unused for compressed data
+    GLenum type;
+    bool compressed;
+};
+
+/**
+ * \brief Maps a KTX2 format onto the GL format it uploads as, or nullopt if the current context
+ * can't sample it natively.
+ */
+inline std::optional<KtxGLFormat> ktxGLFormat(VkFormat f) {
+    bool s3tc = GLExtensions::get().textureCompressionS3TC;
+    switch (f) {
+    case VkFormat::r8g8b8a8_unorm:
+        return KtxGLFormat{GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, false};
+    case VkFormat::r8g8b8a8_srgb:
+        return KtxGLFormat{GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, false};
+    case VkFormat::bc1_rgb_unorm:
+        if (s3tc)
+            return KtxGLFormat{GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, true};
+        break;
+    case VkFormat::bc1_rgb_srgb:
+        if (s3tc)
+            return KtxGLFormat{GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, true};
+        break;
+    case VkFormat::bc3_unorm:
+        if (s3tc)
+            return KtxGLFormat{GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, true};
+        break;
+    case VkFormat::bc3_srgb:
+        if (s3tc)
+            return KtxGLFormat{GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, true};
+        break;
+    case VkFormat::bc7_unorm:
+        return KtxGLFormat{GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, true};
+    case VkFormat::bc7_srgb:
+        return KtxGLFormat{GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, true};
+    default:
+        break;
+    }
+    return std::nullopt;
+}
+
+/**
+ * \brief Creates an immutable texture sized for every level in `img` and queues each level on the
+ * TextureUploadQueue as stored, so nothing is decoded or mip-mapped at runtime. `owner` keeps the
+ * memory the levels point into alive until they are staged. `onUploaded` runs after the last level
+ * has been issued.
+ */
+inline GLTexture createKtx2Texture(const Ktx2Image &img, std::shared_ptr<const void> owner,
+                                   std::function<void(GLuint)> onUploaded = {}) {
+    auto fmt = ktxGLFormat(img.format);
+    if (!fmt)
+        throw std::runtime_error("KTX2 format " +
+                                 std::to_string(static_cast<uint32_t>(img.format)) +
+                                 " is not supported by this GL context");
+
+    auto levels = static_cast<GLsizei>(img.levels.size());
+    size_t bytes = 0;
+    for (auto level : img.levels)
+        bytes += level.size();
+    GLTexture tex(levels, fmt->internalFormat, img.width, img.height, bytes);
+
+    auto &queue = TextureUploadQueue::get();
+    for (GLint level = 0; level < levels; ++level) {
+        auto data = img.levels[level];
+        TextureUpload upload{
+            .texture = tex.get(),
+            .level = level,
+            .width = std::max(1, static_cast<GLsizei>(img.width >> level)),
+            .height = std::max(1, static_cast<GLsizei>(img.height >> level)),
+            .format = fmt->compressed ? fmt->internalFormat : fmt->format,
+            .type = fmt->type,
+            .compressed = fmt->compressed,
+            // aliases `owner`, the level stays valid as long as the whole file does
+            .pixels = std::shared_ptr<const void>(owner, data.data()),
+            .size = data.size(),
+        };
+        if (level == levels - 1)
+            upload.onUploaded = std::move(onUploaded);
+        queue.enqueue(std::move(upload));
+    }
+    return tex;
+}
+
+/**
+ * \brief Parses a KTX2 file and creates its texture, see createKtx2Texture. When the file comes
+ * from a mounted asset pack the levels are staged straight out of the mapping.
+ */
+inline GLTexture loadKtx2Texture(const std::string &path,
+                                 std::function<void(GLuint)> onUploaded = {}) {
+    auto file = load_asset(path);
+    auto img = parse_ktx2(file.bytes);
+    return createKtx2Texture(img, std::move(file.owner), std::move(onUploaded));
+}
@@ -1,13 +1,142 @@
 #pragma once
 #include "shader.hpp"
+#include <algorithm>
+#include <functional>
+#include <glm/gtc/type_ptr.hpp>
+#include <span>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * \brief Precomputed handle to an active uniform, resolved once when the program is linked.
+ * Setting an invalid handle is a no-op, same as passing location -1 to GL.
+ */
+struct UniformHandle {
+    GLint location = -1;
+    GLenum type = GL_NONE;
+    GLint arraySize = 0;
+
+    bool valid() const { return location >= 0; }
+};
+
+/**
+ * \brief Reflected uniform block or shader storage block.
+ */
+struct ProgramBlock {
+    GLuint index = GL_INVALID_INDEX;
+    GLint binding = -1;
+    GLint dataSize = 0;
+};
+
+// transparent hashing so lookups by string_view don't allocate
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+template <typename V>
+using StringMap = std::unordered_map<std::string, V, StringHash, std::equal_to<>>;
+
+inline bool isOpaqueUniformType(GLenum type) {
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_IMAGE_2D:
+    case GL_IMAGE_3D:
+    case GL_IMAGE_2D_ARRAY:
+    case GL_IMAGE_BUFFER:
+    case GL_INT_IMAGE_2D:
+    case GL_UNSIGNED_INT_IMAGE_2D:
+        return true;
+    default:
+        return false;
+    }
+}
 
 class GLProgram {
   private:
     GLuint id;
+    StringMap<UniformHandle> uniforms;
+    StringMap<ProgramBlock> uniformBlocks;
+    StringMap<ProgramBlock> storageBlocks;
+
+    static std::string resourceName(GLuint program, GLenum interface, GLuint index, GLint length) {
+        std::string name(static_cast<size_t>(length), '\0');
+        GLsizei written = 0;
+        glGetProgramResourceName(program, interface, index, length, &written, name.data());
+        name.resize(written);
+        // arrays are reported as "name[0]", we want to look them up by "name"
+        if (name.ends_with("[0]"))
+            name.resize(name.size() - 3);
+        return name;
+    }
+
+    void reflectBlocks(GLenum interface, StringMap<ProgramBlock> &out) {
+        GLint count = 0;
+        glGetProgramInterfaceiv(id, interface, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = {GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[3];
+            glGetProgramResourceiv(id, interface, i, 3, props, 3, nullptr, values);
+            out[resourceName(id, interface, i, values[0])] = {static_cast<GLuint>(i), values[1],
+                                                              values[2]};
+        }
+    }
+
+    // Walks every active resource once after linking, so nothing has to query GL by name later.
+    void reflect() {
+        GLint count = 0;
+        glGetProgramInterfaceiv(id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE,
+                                GL_BLOCK_INDEX};
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[5];
+            glGetProgramResourceiv(id, GL_UNIFORM, i, 5, props, 5, nullptr, values);
+            // members of uniform blocks don't have locations, they're set through the buffer
+            if (values[4] != -1)
+                continue;
+            uniforms[resourceName(id, GL_UNIFORM, i, values[0])] = {
+                values[2], static_cast<GLenum>(values[1]), values[3]};
+        }
+
+        reflectBlocks(GL_UNIFORM_BLOCK, uniformBlocks);
+        reflectBlocks(GL_SHADER_STORAGE_BLOCK, storageBlocks);
+    }
+
+    bool check(const UniformHandle &u, bool accepted) const {
+        if (!u.valid())
+            return false;
+#ifndef NDEBUG
+        if (!accepted) {
+            spdlog::warn("uniform type mismatch on program {} location {} (GL type 0x{:x})", id,
+                         u.location, u.type);
+            return false;
+        }
+#endif
+        return true;
+    }
 
   public:
     GLProgram(const GLShader &vertexShader, const GLShader &fragmentShader)
-        : id(linkModules(vertexShader.get(), fragmentShader.get())) {}
+        : id(linkModules(vertexShader.get(), fragmentShader.get())) {
+        reflect();
+    }
+
+    explicit GLProgram(const GLShader &computeShader) : id(linkModules({computeShader.get()})) {
+        reflect();
+    }
 
     ~GLProgram() {
         if (id != 0) {
@@ -16,16 +145,90 @@ class GLProgram {
     }
 
     void use() const { glUseProgram(id); }
-    void setUniform(GLuint location, GLuint value) const { glUniform1ui(location, value); }
+
+    /**
+     * \brief Looks up a reflected uniform. Meant to be called once at setup, the returned handle is
+     * what should be kept around for per-frame updates.
+     */
+    UniformHandle uniform(std::string_view name) const {
+        auto it = uniforms.find(name);
+        if (it == uniforms.end()) {
+            spdlog::warn("uniform '{}' is not active in program {}", name, id);
+            return {};
+        }
+        return it->second;
+    }
+
+    const ProgramBlock *uniformBlock(std::string_view name) const {
+        auto it = uniformBlocks.find(name);
+        return it == uniformBlocks.end() ? nullptr : &it->second;
+    }
+
+    const ProgramBlock *storageBlock(std::string_view name) const {
+        auto it = storageBlocks.find(name);
+        return it == storageBlocks.end() ? nullptr : &it->second;
+    }
+
+    const StringMap<UniformHandle> &activeUniforms() const { return uniforms; }
+
+    // All setters go through glProgramUniform*, so the program doesn't need to be bound.
+    void set(const UniformHandle &u, GLint value) const {
+        if (check(u, u.type == GL_INT || u.type == GL_BOOL || isOpaqueUniformType(u.type)))
+            glProgramUniform1i(id, u.location, value);
+    }
+    void set(const UniformHandle &u, GLuint value) const {
+        if (check(u, u.type == GL_UNSIGNED_INT || u.type == GL_BOOL))
+            glProgramUniform1ui(id, u.location, value);
+    }
+    void set(const UniformHandle &u, bool value) const {
+        if (check(u, u.type == GL_BOOL))
+            glProgramUniform1i(id, u.location, value ? 1 : 0);
+    }
+    void set(const UniformHandle &u, float value) const {
+        if (check(u, u.type == GL_FLOAT))
+            glProgramUniform1f(id, u.location, value);
+    }
+    void set(const UniformHandle &u, const glm::vec2 &value) const {
+        if (check(u, u.type == GL_FLOAT_VEC2))
+            glProgramUniform2fv(id, u.location, 1, glm::value_ptr(value));
+    }
+    void set(const UniformHandle &u, const glm::vec3 &value) const {
+        if (check(u, u.type == GL_FLOAT_VEC3))
+            glProgramUniform3fv(id, u.location, 1, glm::value_ptr(value));
+    }
+    void set(const UniformHandle &u, const glm::vec4 &value) const {
+        if (check(u, u.type == GL_FLOAT_VEC4))
+            glProgramUniform4fv(id, u.location, 1, glm::value_ptr(value));
+    }
+    void set(const UniformHandle &u, std::span<const glm::vec4> values) const {
+        if (values.empty())
+            return;
+        if (check(u, u.type == GL_FLOAT_VEC4))
+            glProgramUniform4fv(id, u.location,
+                                std::min(static_cast<GLint>(values.size()), u.arraySize),
+                                glm::value_ptr(*values.data()));
+    }
+    void set(const UniformHandle &u, const glm::mat4 &value) const {
+        if (check(u, u.type == GL_FLOAT_MAT4))
+            glProgramUniformMatrix4fv(id, u.location, 1, GL_FALSE, glm::value_ptr(value));
+    }
 
     GLuint get() const { return id; }
 
     // Allow moving
-    GLProgram(GLProgram &&other) noexcept : id(other.id) { other.id = 0; }
+    GLProgram(GLProgram &&other) noexcept
+        : id(other.id), uniforms(std::move(other.uniforms)),
+          uniformBlocks(std::move(other.uniformBlocks)),
+          storageBlocks(std::move(other.storageBlocks)) {
+        other.id = 0;
+    }
     GLProgram &operator=(GLProgram &&other) noexcept {
         if (this != &other) {
             glDeleteProgram(id);
             id = other.id;
+            uniforms = std::move(other.uniforms);
+            uniformBlocks = std::move(other.uniformBlocks);
+            storageBlocks = std::move(other.storageBlocks);
             other.id = 0;
         }
         return *this;
@@ -34,4 +237,4 @@ class GLProgram {
     // Prevent copying
     GLProgram(const GLProgram &) = delete;
     GLProgram &operator=(const GLProgram &) = delete;
-};
\ No newline at end of file
+};
@@ -0,0 +1,221 @@
+#pragma once
+#include "program.hpp"
+#include "shader_manager.hpp"
+#include "stream_buffer.hpp"
+#include "vertex_formats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \brief A single textured, tinted and rotated quad in window pixel coordinates (origin top-left).
+ */
+struct Quad {
+    glm::vec2 position; // center
+    glm::vec2 size;
+    float rotation = 0.0f;                   // radians
+    glm::vec4 uv = {0.0f, 0.0f, 1.0f, 1.0f}; // min.xy, max.xy
+    glm::vec4 color = {1.0f, 1.0f, 1.0f, 1.0f};
+    GLuint texture = 0;                 // 0 draws untextured
+    const GLProgram *program = nullptr; // nullptr uses the built-in quad program
+    uint16_t layer = 0;                 // higher layers draw later, regardless of texture
+};
+
+// What a quad turns into on the GPU, one per instance.
+struct QuadInstance {
+    glm::vec4 rect; // center.xy, size.xy
+    glm::vec2 rotation;
+    glm::vec4 uv;
+    unorm8x4 color;
+};
+
+#define QUAD_INSTANCE_FIELDS(X)                                                                    \
+    X(rect, 0)                                                                                     \
+    X(rotation, 1)                                                                                 \
+    X(uv, 2)                                                                                       \
+    X(color, 3)
+
+MAKE_VERTEX_LAYOUT(QuadInstance, 1, QUAD_INSTANCE_FIELDS);
+
+/**
+ * \brief Collects quads during a frame and draws them instanced, one draw call per run of quads
+ * sharing a layer, program and texture. Custom programs have to consume the same per-instance
+ * attributes as the built-in vertex shader and declare `uniform vec2 uViewport`.
+ *
+ * Main owns one for the whole run (State::quads): modules submit during the frame and it is
+ * flushed into the scene after the render passes.
+ */
+class QuadBatch {
+  public:
+    struct Stats {
+        size_t quads = 0;
+        size_t batches = 0;
+    };
+
+  private:
+    static constexpr const char *VERTEX_SHADER_SOURCE = R"(
+#version 450 core
+layout(location = 0) in vec4 iRect;     // center.xy, size.xy
+layout(location = 1) in vec2 iRotation; // cos, sin
+layout(location = 2) in vec4 iUV;
+layout(location = 3) in vec4 iColor;
+
+uniform vec2 uViewport;
+
+out vec2 vUV;
+out vec4 vColor;
+
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 local = (corner - 0.5) * iRect.zw;
+    vec2 rotated = vec2(local.x * iRotation.x - local.y * iRotation.y,
+                        local.x * iRotation.y + local.y * iRotation.x);
+    vec2 ndc = (iRect.xy + rotated) / uViewport * 2.0 - 1.0;
+    vUV = mix(iUV.xy, iUV.zw, corner);
+    vColor = iColor;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
+)";
+
+    static constexpr const char *FRAGMENT_SHADER_SOURCE = R"(
+#version 450 core
+in vec2 vUV;
+in vec4 vColor;
+layout(location = 0) out vec4 outColor;
+
+uniform sampler2D uTexture;
+
+void main() {
+    outColor = texture(uTexture, vUV) * vColor;
+}
+)";
+
+    struct Entry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::unique_ptr<GLProgram> defaultProgram;
+    std::shared_ptr<GLVertexArray> vao;
+    GLStreamBuffer<QuadInstance> instances;
+    GLuint white = 0;
+
+    std::vector<QuadInstance> pending;
+    std::vector<Entry> order;
+    std::vector<const GLProgram *> programs; // slot in the sort key -> program, rebuilt per flush
+    // by GL name, a program freed and rebuilt at the same address must not hit a stale location
+    std::unordered_map<GLuint, UniformHandle> viewportHandles;
+    Stats stats;
+
+    uint64_t programSlot(const GLProgram *program) {
+        auto it = std::find(programs.begin(), programs.end(), program);
+        if (it != programs.end())
+            return static_cast<uint64_t>(it - programs.begin());
+        programs.push_back(program);
+        return programs.size() - 1;
+    }
+
+    const UniformHandle &viewportHandle(const GLProgram *program) {
+        auto it = viewportHandles.find(program->get());
+        if (it == viewportHandles.end())
+            it = viewportHandles.emplace(program->get(), program->uniform("uViewport")).first;
+        return it->second;
+    }
+
+  public:
+    explicit QuadBatch(size_t initialCapacity = 4096) : instances(initialCapacity) {
+        auto vs = ShaderManager::get().getShader("quad_batch_vertex", GL_VERTEX_SHADER,
+                                                 VERTEX_SHADER_SOURCE);
+        auto fs = ShaderManager::get().getShader("quad_batch_fragment", GL_FRAGMENT_SHADER,
+                                                 FRAGMENT_SHADER_SOURCE);
+        defaultProgram = std::make_unique<GLProgram>(*vs, *fs);
+        defaultProgram->set(defaultProgram->uniform("uTexture"), 0);
+
+        vao = VertexArrayCache::get().acquire<QuadInstance>();
+
+        const uint32_t pixel = 0xffffffff;
+        glCreateTextures(GL_TEXTURE_2D, 1, &white);
+        glTextureStorage2D(white, 1, GL_RGBA8, 1, 1);
+        glTextureSubImage2D(white, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixel);
+    }
+
+    ~QuadBatch() { glDeleteTextures(1, &white); }
+
+    void submit(const Quad &q) {
+        const GLProgram *program = q.program ? q.program : defaultProgram.get();
+        uint64_t key = static_cast<uint64_t>(q.layer) << 48 | programSlot(program) << 32 |
+                       (q.texture ? q.texture : white);
+        order.push_back({key, static_cast<uint32_t>(pending.size())});
+        pending.push_back({{q.position, q.size},
+                           {std::cos(q.rotation), std::sin(q.rotation)},
+                           q.uv,
+                           unorm8x4::from(q.color)});
+    }
+
+    /**
+     * \brief Draws everything submitted since the last flush into the currently bound
+     * framebuffer. Within a batch quads keep their submission order.
+     */
+    void flush(int viewportWidth, int viewportHeight) {
+        stats = {pending.size(), 0};
+        if (pending.empty())
+            return;
+
+        std::stable_sort(order.begin(), order.end(),
+                         [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+        auto region = instances.acquire(pending.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            region.data[i] = pending[order[i].index];
+
+        vao->setVertexBuffer(instances.get(), 0, sizeof(QuadInstance),
+                             static_cast<GLuint>(region.first * sizeof(QuadInstance)));
+        vao->bind();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        const glm::vec2 viewport(static_cast<float>(viewportWidth),
+                                 static_cast<float>(viewportHeight));
+        const GLProgram *bound = nullptr;
+        size_t start = 0;
+        while (start < order.size()) {
+            uint64_t key = order[start].key;
+            size_t end = start + 1;
+            while (end < order.size() && order[end].key == key)
+                end++;
+
+            const GLProgram *program = programs[(key >> 32) & 0xffff];
+            if (program != bound) {
+                program->set(viewportHandle(program), viewport);
+                program->use();
+                bound = program;
+            }
+            glBindTextureUnit(0, static_cast<GLuint>(key & 0xffffffff));
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4,
+                                              static_cast<GLsizei>(end - start),
+                                              static_cast<GLuint>(start));
+            stats.batches++;
+            start = end;
+        }
+
+        glDisable(GL_BLEND);
+        instances.release();
+        pending.clear();
+        order.clear();
+        programs.clear();
+    }
+
+    /**
+     * \brief Forgets what was looked up in custom programs. GL reuses the names of deleted
+     * programs, so this has to be called whenever they may have been rebuilt, e.g. on reload.
+     */
+    void invalidatePrograms() { viewportHandles.clear(); }
+
+    const Stats &getStats() const { return stats; }
+
+    QuadBatch(const QuadBatch &) = delete;
+    QuadBatch &operator=(const QuadBatch &) = delete;
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include "texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+struct RenderTargetDesc {
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLenum colorFormat = GL_RGBA8;
+    GLenum depthFormat = GL_DEPTH24_STENCIL8; // 0 for color only
+    GLsizei samples = 0;                      // > 1 for multisampling
+
+    bool operator==(const RenderTargetDesc &) const = default;
+
+    // Same attachments, so one can stand in for the other if it is large enough.
+    bool compatible(const RenderTargetDesc &other) const {
+        return colorFormat == other.colorFormat && depthFormat == other.depthFormat &&
+               samples == other.samples;
+    }
+};
+
+/**
+ * \brief Framebuffer with a color attachment and an optional depth renderbuffer. The allocation
+ * can be larger than the area in use, width() and height() are the part that is drawn to and
+ * read from, starting at the origin. Single sampled targets have a sampleable color texture,
+ * multisampled ones a renderbuffer that has to be resolved by blitting.
+ */
+class RenderTarget {
+  private:
+    RenderTargetDesc desc;
+    GLsizei usedWidth, usedHeight;
+    GLTexture color;
+    GLuint colorBuffer = 0;
+    GLuint depth = 0;
+    GLuint fbo = 0;
+
+    static size_t bytesPerPixel(GLenum format) {
+        switch (format) {
+        case GL_RGBA16F:
+            return 8;
+        case GL_RGBA32F:
+            return 16;
+        default: // RGBA8, R11F_G11F_B10F and the depth formats
+            return 4;
+        }
+    }
+
+    size_t pixelBytes(GLenum format) const {
+        return size_t(desc.width) * desc.height * bytesPerPixel(format) *
+               std::max<size_t>(desc.samples, 1);
+    }
+
+  public:
+    explicit RenderTarget(const RenderTargetDesc &desc)
+        : desc(desc), usedWidth(desc.width), usedHeight(desc.height) {
+        // attachments have to agree on the sample count, 1 is the same as none
+        GLsizei samples = desc.samples > 1 ? desc.samples : 0;
+        glCreateFramebuffers(1, &fbo);
+        if (samples) {
+            glCreateRenderbuffers(1, &colorBuffer);
+            glNamedRenderbufferStorageMultisample(colorBuffer, samples, desc.colorFormat,
+                                                  desc.width, desc.height);
+            glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                           colorBuffer);
+        } else {
+            color = GLTexture(1, desc.colorFormat, desc.width, desc.height,
+                              pixelBytes(desc.colorFormat));
+            glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, color.get(), 0);
+        }
+        if (desc.depthFormat) {
+            glCreateRenderbuffers(1, &depth);
+            glNamedRenderbufferStorageMultisample(depth, samples, desc.depthFormat, desc.width,
+                                                  desc.height);
+            GLenum attachment = desc.depthFormat == GL_DEPTH24_STENCIL8
+                                    ? GL_DEPTH_STENCIL_ATTACHMENT
+                                    : GL_DEPTH_ATTACHMENT;
+            glNamedFramebufferRenderbuffer(fbo, attachment, GL_RENDERBUFFER, depth);
+        }
+        if (glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            glDeleteFramebuffers(1, &fbo);
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteRenderbuffers(1, &depth);
+            throw std::runtime_error("Render target framebuffer is incomplete");
+        }
+    }
+
+    ~RenderTarget() {
+        glDeleteFramebuffers(1, &fbo);
+        if (colorBuffer)
+            glDeleteRenderbuffers(1, &colorBuffer);
+        if (depth)
+            glDeleteRenderbuffers(1, &depth);
+    }
+
+    // Binds the framebuffer for drawing and sets the viewport to the area in use.
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, usedWidth, usedHeight);
+    }
+
+    // Changes the area in use, it has to fit inside the allocation.
+    void setSize(GLsizei width, GLsizei height) {
+        usedWidth = std::clamp(width, 1, desc.width);
+        usedHeight = std::clamp(height, 1, desc.height);
+    }
+
+    GLuint get() const { return fbo; }
+    GLuint colorTexture() const { return color.get(); }
+    // The allocation, which may be larger than the area in use.
+    const RenderTargetDesc &getDesc() const { return desc; }
+    GLsizei width() const { return usedWidth; }
+    GLsizei height() const { return usedHeight; }
+    size_t bytes() const {
+        return pixelBytes(desc.colorFormat) + (depth ? pixelBytes(desc.depthFormat) : 0);
+    }
+    // Part of bytes() outside the area in use.
+    size_t slackBytes() const {
+        size_t area = size_t(desc.width) * desc.height;
+        size_t used = size_t(usedWidth) * usedHeight;
+        return bytes() / area * (area - used);
+    }
+
+    RenderTarget(const RenderTarget &) = delete;
+    RenderTarget &operator=(const RenderTarget &) = delete;
+};
+
+struct RenderTargetPoolStats {
+    size_t targets = 0;
+    size_t inUse = 0;
+    size_t bytes = 0;
+    size_t peakBytes = 0;
+    size_t slackBytes = 0; // allocated beyond what in-use targets draw to
+    size_t created = 0;
+    bool resizing = false;
+};
+
+/**
+ * \brief Hands out render targets by format, sample count and size bucket, and recycles them once
+ * the last shared_ptr to them is gone, so passes that need an offscreen buffer don't reallocate
+ * one every frame.
+ *
+ * Allocations are rounded up to a bucket, so small size changes reuse the same target. While the
+ * window is being resized any free target that is large enough is reused and new ones get extra
+ * headroom, so a drag doesn't allocate a target per frame. Once the size has settled, targets are
+ * traded for ones of their exact bucket again and the oversized ones age out.
+ */
+class RenderTargetPool {
+  private:
+    static constexpr uint64_t MAX_IDLE_FRAMES = 120;
+    static constexpr GLsizei BUCKET = 64;
+    // frames without a resize before the window counts as settled
+    static constexpr uint64_t SETTLE_FRAMES = 30;
+    static constexpr double RESIZE_HEADROOM = 1.25;
+
+    struct Entry {
+        std::shared_ptr<RenderTarget> target;
+        uint64_t lastUsed = 0;
+    };
+    std::vector<Entry> entries;
+    uint64_t frame = 0;
+    uint64_t resizeUntil = 0;
+    RenderTargetPoolStats stats;
+
+    static GLsizei bucket(double size) {
+        auto s = static_cast<GLsizei>(std::ceil(size));
+        return std::max((s + BUCKET - 1) / BUCKET * BUCKET, BUCKET);
+    }
+
+    bool resizing() const { return frame < resizeUntil; }
+
+    bool keeps(const RenderTarget &target, const RenderTargetDesc &desc) const {
+        auto &a = target.getDesc();
+        if (!a.compatible(desc) || a.width < desc.width || a.height < desc.height)
+            return false;
+        return resizing() || (a.width == bucket(desc.width) && a.height == bucket(desc.height));
+    }
+
+  public:
+    static RenderTargetPool &get() {
+        static RenderTargetPool instance;
+        return instance;
+    }
+
+    /**
+     * \brief A free target that can hold `desc`, created if there is none. Its width() and
+     * height() are set to the requested size.
+     */
+    std::shared_ptr<RenderTarget> acquire(const RenderTargetDesc &desc) {
+        for (auto &e : entries) {
+            if (e.target.use_count() == 1 && keeps(*e.target, desc)) {
+                e.lastUsed = frame;
+                e.target->setSize(desc.width, desc.height);
+                return e.target;
+            }
+        }
+        double headroom = resizing() ? RESIZE_HEADROOM : 1.0;
+        RenderTargetDesc alloc = desc;
+        alloc.width = bucket(desc.width * headroom);
+        alloc.height = bucket(desc.height * headroom);
+        auto target = std::make_shared<RenderTarget>(alloc);
+        target->setSize(desc.width, desc.height);
+        entries.push_back({target, frame});
+        stats.created++;
+        return target;
+    }
+
+    /**
+     * \brief Keeps `slot` if it can still hold `desc`, otherwise trades it for one that can.
+     * For owners that hold a target across frames, comparing the pointer before and after tells
+     * whether the old contents survived.
+     */
+    void fit(std::shared_ptr<RenderTarget> &slot, const RenderTargetDesc &desc) {
+        if (slot && keeps(*slot, desc)) {
+            slot->setSize(desc.width, desc.height);
+            return;
+        }
+        slot.reset();
+        slot = acquire(desc);
+    }
+
+    // Called from the framebuffer size callback, holds off shrinking until the size settles.
+    void notifyResize() { resizeUntil = frame + SETTLE_FRAMES; }
+
+    // Frees targets nobody has used for a while. Call once per frame.
+    void collect() {
+        frame++;
+        std::erase_if(entries, [this](const Entry &e) {
+            return e.target.use_count() == 1 && frame - e.lastUsed > MAX_IDLE_FRAMES;
+        });
+
+        stats.targets = entries.size();
+        stats.inUse = 0;
+        stats.bytes = 0;
+        stats.slackBytes = 0;
+        stats.resizing = resizing();
+        for (auto &e : entries) {
+            stats.bytes += e.target->bytes();
+            if (e.target.use_count() > 1) {
+                stats.inUse++;
+                stats.slackBytes += e.target->slackBytes();
+                e.lastUsed = frame;
+            }
+        }
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+    }
+
+    // Drops every pooled target, at shutdown while the context is still alive. Targets somebody
+    // else still holds are deleted when they let go of them.
+    void clear() { entries.clear(); }
+
+    const RenderTargetPoolStats &getStats() const { return stats; }
+
+  private:
+    // GLTexture cancels uploads on destruction, so the queue has to outlive the pool
+    RenderTargetPool() { TextureUploadQueue::get(); }
+};
@@ -1,12 +1,142 @@
 #pragma once
 #include "shader.hpp"
+#include <chrono>
+#include <cstdint>
+#include <fmt/core.h>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+/**
+ * \brief Maps the bits of a shader feature enum to the preprocessor defines they turn on.
+ * Specialize it through MAKE_SHADER_FEATURES, the enum values have to be single bits.
+ */
+template <typename E> struct ShaderFeatureTraits;
+
+#define FEATURE_DEFINE(value, define) std::pair{value, define},
+
+#define MAKE_SHADER_FEATURES(ENUM, FEATURES_MACRO)                                                 \
+    template <> struct ShaderFeatureTraits<ENUM> {                                                 \
+        static constexpr std::pair<ENUM, const char *> defines[] = {                               \
+            FEATURES_MACRO(FEATURE_DEFINE)};                                                       \
+    }
+
+/**
+ * \brief Compile-time typed set of features for one shader. The feature enum is part of the type,
+ * so a key built for one shader can't be handed to another one by mistake.
+ */
+template <typename E> struct ShaderVariantKey {
+    uint32_t bits = 0;
+
+    constexpr ShaderVariantKey() = default;
+    constexpr ShaderVariantKey(E feature) : bits(static_cast<uint32_t>(feature)) {}
+
+    constexpr ShaderVariantKey operator|(ShaderVariantKey other) const {
+        ShaderVariantKey k;
+        k.bits = bits | other.bits;
+        return k;
+    }
+    constexpr ShaderVariantKey with(E feature, bool enabled = true) const {
+        ShaderVariantKey k;
+        k.bits = enabled ? bits | static_cast<uint32_t>(feature)
+                         : bits & ~static_cast<uint32_t>(feature);
+        return k;
+    }
+    constexpr bool has(E feature) const { return (bits & static_cast<uint32_t>(feature)) != 0; }
+
+    std::string defines() const {
+        std::string out;
+        for (const auto &[feature, define] : ShaderFeatureTraits<E>::defines) {
+            if (has(feature))
+                out += fmt::format("#define {} 1\n", define);
+        }
+        return out;
+    }
+};
+
+struct ShaderStats {
+    size_t variants = 0;
+    double totalCompileMs = 0.0;
+    double slowestCompileMs = 0.0;
+    std::string slowest;
+};
 
 class ShaderManager {
   private:
     std::unordered_map<std::string, std::shared_ptr<GLShader>> shaders;
+    std::unordered_map<std::string, std::string> includes;
+    ShaderStats stats;
+
+    void resolveIncludes(const std::string &source, std::string &out,
+                         std::unordered_set<std::string> &seen) const {
+        std::istringstream in(source);
+        std::string line;
+        while (std::getline(in, line)) {
+            auto start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+                out += line;
+                out += '\n';
+                continue;
+            }
+
+            auto open = line.find('"', start);
+            auto close = line.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos)
+                throw std::runtime_error("Malformed shader include: " + line);
+
+            auto name = line.substr(open + 1, close - open - 1);
+            auto it = includes.find(name);
+            if (it == includes.end())
+                throw std::runtime_error("Unknown shader include: " + name);
+            // every include acts like it has a pragma once, which also stops cycles
+            if (seen.insert(name).second)
+                resolveIncludes(it->second, out, seen);
+        }
+    }
+
+    // Resolves includes and injects the defines right after #version, which has to stay first.
+    std::string preprocess(const std::string &source, const std::string &defines) const {
+        std::string resolved;
+        std::unordered_set<std::string> seen;
+        resolveIncludes(source, resolved, seen);
+
+        if (defines.empty())
+            return resolved;
+
+        auto version = resolved.find("#version");
+        if (version == std::string::npos)
+            return defines + resolved;
+        auto eol = resolved.find('\n', version);
+        if (eol == std::string::npos)
+            return resolved + '\n' + defines;
+        return resolved.insert(eol + 1, defines);
+    }
+
+    std::shared_ptr<GLShader> compile(const std::string &key, GLenum type,
+                                      const std::string &source, const std::string &defines) {
+        auto it = shaders.find(key);
+        if (it != shaders.end()) {
+            return it->second;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto shader = std::make_shared<GLShader>(type, preprocess(source, defines));
+        std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+
+        stats.variants++;
+        stats.totalCompileMs += took.count();
+        if (took.count() > stats.slowestCompileMs) {
+            stats.slowestCompileMs = took.count();
+            stats.slowest = key;
+        }
+
+        shaders[key] = shader;
+        return shader;
+    }
 
   public:
     static ShaderManager &get() {
@@ -14,18 +144,30 @@ class ShaderManager {
         return instance;
     }
 
+    /**
+     * \brief Registers a source that shaders can pull in with #include "name".
+     */
+    void addInclude(const std::string &name, std::string source) {
+        includes[name] = std::move(source);
+    }
+
     std::shared_ptr<GLShader> getShader(const std::string &name, GLenum type,
                                         const std::string &source) {
-        auto it = shaders.find(name);
-        if (it != shaders.end()) {
-            return it->second;
-        }
+        return compile(name, type, source, "");
+    }
 
-        auto shader = std::make_shared<GLShader>(type, source);
-        shaders[name] = shader;
-        return shader;
+    /**
+     * \brief Returns the variant of a shader specialized for the given features, compiling it on
+     * first use. Each feature turns into a #define so disabled branches are removed entirely.
+     */
+    template <typename E>
+    std::shared_ptr<GLShader> getVariant(const std::string &name, GLenum type,
+                                         const std::string &source, ShaderVariantKey<E> key) {
+        return compile(fmt::format("{}#{:x}", name, key.bits), type, source, key.defines());
     }
 
+    const ShaderStats &getStats() const { return stats; }
+
   private:
     ShaderManager() = default;
-};
\ No newline at end of file
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "buffer.hpp"
+#include <array>
+#include <bit>
+#include <memory>
+#include <span>
+
+/**
+ * \brief Persistently mapped buffer split into SEGMENTS regions that are written round-robin.
+ * Each region is fenced once the GPU work reading it has been submitted, and only waited on when
+ * the ring wraps around to it again, so writing the next batch never stalls on the previous one.
+ */
+template <typename T, size_t SEGMENTS = 3> class GLStreamBuffer {
+  private:
+    std::unique_ptr<GLBuffer<T>> buffer;
+    T *mapped = nullptr;
+    size_t capacity = 0; // elements per segment
+    size_t current = 0;
+    std::array<GLsync, SEGMENTS> fences{};
+
+    static constexpr GLbitfield FLAGS =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    void wait(GLsync &fence) {
+        if (!fence)
+            return;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) ==
+               GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void reallocate(size_t elements) {
+        for (auto &fence : fences)
+            wait(fence);
+        if (buffer)
+            glUnmapNamedBuffer(buffer->get());
+
+        capacity = std::bit_ceil(elements);
+        buffer = std::make_unique<GLBuffer<T>>();
+        buffer->allocate(capacity * SEGMENTS, FLAGS);
+        mapped = static_cast<T *>(
+            glMapNamedBufferRange(buffer->get(), 0, capacity * SEGMENTS * sizeof(T), FLAGS));
+        if (!mapped)
+            throw std::runtime_error("Failed to map stream buffer");
+        current = 0;
+    }
+
+  public:
+    struct Region {
+        std::span<T> data;
+        size_t first; // element offset of the region inside the whole buffer
+    };
+
+    explicit GLStreamBuffer(size_t initialCapacity = 1024) { reallocate(initialCapacity); }
+
+    ~GLStreamBuffer() {
+        for (auto &fence : fences) {
+            if (fence)
+                glDeleteSync(fence);
+        }
+        if (buffer)
+            glUnmapNamedBuffer(buffer->get());
+    }
+
+    /**
+     * \brief Returns the next writable region holding at least `count` elements. Grows the buffer
+     * if needed, and waits for the GPU only if it is still reading this region from SEGMENTS
+     * submissions ago.
+     */
+    Region acquire(size_t count) {
+        if (count > capacity)
+            reallocate(count);
+        wait(fences[current]);
+        return {std::span<T>(mapped + current * capacity, capacity), current * capacity};
+    }
+
+    // Call after the draws reading the acquired region have been issued.
+    void release() {
+        fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        current = (current + 1) % SEGMENTS;
+    }
+
+    const GLBuffer<T> &get() const { return *buffer; }
+    size_t segmentCapacity() const { return capacity; }
+
+    GLStreamBuffer(const GLStreamBuffer &) = delete;
+    GLStreamBuffer &operator=(const GLStreamBuffer &) = delete;
+};
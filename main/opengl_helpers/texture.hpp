@@ -0,0 +1,64 @@
+#pragma once
+#include "texture_upload.hpp"
+
+/**
+ * \brief Owns an immutable 2D texture. Destroying it also drops any of its uploads still waiting
+ * in the TextureUploadQueue, so a texture can be released before it ever finished streaming in.
+ */
+class GLTexture {
+  private:
+    GLuint id = 0;
+    GLsizei w = 0, h = 0, levels = 0;
+    size_t byteSize = 0;
+
+    void release() {
+        if (!id)
+            return;
+        TextureUploadQueue::get().cancel(id);
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+
+  public:
+    // Empty, owns nothing until a texture is moved in.
+    GLTexture() = default;
+
+    /**
+     * \param bytes What the storage costs in VRAM, for budgeting. The caller knows it best since
+     * it depends on the format and the number of levels.
+     */
+    GLTexture(GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, size_t bytes)
+        : w(width), h(height), levels(levels), byteSize(bytes) {
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        glTextureStorage2D(id, levels, internalFormat, width, height);
+        glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    ~GLTexture() { release(); }
+
+    GLuint get() const { return id; }
+    GLsizei width() const { return w; }
+    GLsizei height() const { return h; }
+    GLsizei levelCount() const { return levels; }
+    size_t bytes() const { return byteSize; }
+
+    // Prevent copying, allow moving
+    GLTexture(const GLTexture &) = delete;
+    GLTexture &operator=(const GLTexture &) = delete;
+    GLTexture(GLTexture &&other) noexcept
+        : id(other.id), w(other.w), h(other.h), levels(other.levels), byteSize(other.byteSize) {
+        other.id = 0;
+    }
+    GLTexture &operator=(GLTexture &&other) noexcept {
+        if (this != &other) {
+            release();
+            id = other.id;
+            w = other.w;
+            h = other.h;
+            levels = other.levels;
+            byteSize = other.byteSize;
+            other.id = 0;
+        }
+        return *this;
+    }
+};
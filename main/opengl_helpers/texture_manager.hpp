@@ -0,0 +1,278 @@
+#pragma once
+#include "../image_decode.h"
+#include "../jobs.h"
+#include "ktx_texture.hpp"
+#include "texture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SamplerDesc {
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+    GLenum wrapS = GL_REPEAT;
+    GLenum wrapT = GL_REPEAT;
+
+    auto operator<=>(const SamplerDesc &) const = default;
+};
+
+struct TextureParams {
+    SamplerDesc sampler;
+    // the rest only affect decoded images, KTX2 and raw files are stored ready to upload
+    bool srgb = false;
+    bool premultiply = false;
+    MipFilter mipFilter = MipFilter::box;
+};
+
+struct TextureStats {
+    size_t textures = 0;
+    size_t unused = 0; // cached with no handle left, first in line for eviction
+    size_t bytes = 0;
+    size_t samplers = 0;
+    size_t hits = 0;
+    size_t loads = 0;
+    size_t evictions = 0;
+    size_t decoding = 0; // waiting on the job system
+};
+
+// A cached texture, shared by every handle that loaded the same path with the same parameters.
+struct ManagedTexture {
+    GLTexture texture;
+    bool ready = false; // all levels have been issued to GL
+    uint64_t lastUsed = 0;
+};
+
+/**
+ * \brief Reference to a managed texture plus the sampler it was requested with. Textures stay
+ * cached after the last handle goes away and are only evicted when over the VRAM budget.
+ */
+class TextureHandle {
+  private:
+    std::shared_ptr<ManagedTexture> tex;
+    GLuint sampler = 0;
+    const uint64_t *frame = nullptr;
+
+  public:
+    TextureHandle() = default;
+    TextureHandle(std::shared_ptr<ManagedTexture> tex, GLuint sampler, const uint64_t *frame)
+        : tex(std::move(tex)), sampler(sampler), frame(frame) {}
+
+    explicit operator bool() const { return tex != nullptr; }
+    bool ready() const { return tex && tex->ready; }
+    GLuint get() const { return tex ? tex->texture.get() : 0; }
+    const GLTexture &texture() const { return tex->texture; }
+
+    // Binds texture and sampler to `unit`, and marks the texture as used this frame.
+    void bind(GLuint unit) const {
+        tex->lastUsed = *frame;
+        glBindTextureUnit(unit, tex->texture.get());
+        glBindSampler(unit, sampler);
+    }
+};
+
+/**
+ * \brief Loads and caches textures by path and parameters, and owns the sampler objects they are
+ * sampled with. Unused textures are evicted least recently used first once the total goes over
+ * the budget passed to collect().
+ */
+class TextureManager {
+  private:
+    std::unordered_map<std::string, std::shared_ptr<ManagedTexture>> textures;
+    std::map<SamplerDesc, GLuint> samplers;
+    uint64_t frame = 0;
+    TextureStats stats;
+
+    GLuint sampler(const SamplerDesc &desc) {
+        auto it = samplers.find(desc);
+        if (it != samplers.end())
+            return it->second;
+
+        GLuint id;
+        glCreateSamplers(1, &id);
+        glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+        glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+        glSamplerParameteri(id, GL_TEXTURE_WRAP_S, desc.wrapS);
+        glSamplerParameteri(id, GL_TEXTURE_WRAP_T, desc.wrapT);
+        samplers[desc] = id;
+        stats.samplers = samplers.size();
+        return id;
+    }
+
+    struct PendingDecode {
+        std::string key;
+        std::shared_ptr<ManagedTexture> entry;
+        std::future<DecodedImage> image;
+    };
+    std::vector<PendingDecode> pending;
+
+    // Allocates storage for a decoded image and queues its levels. Mips are built with the image
+    // on the job system, only a raw file stored without them still needs the GPU to fill them in.
+    static void uploadDecoded(ManagedTexture &entry, DecodedImage img) {
+        int w = static_cast<int>(img.width), h = static_cast<int>(img.height);
+        int levels = 1 + static_cast<int>(std::log2(std::max(w, h)));
+        size_t bytes = 0;
+        for (int i = 0; i < levels; ++i)
+            bytes += size_t(std::max(1, w >> i)) * std::max(1, h >> i) * 4;
+        GLenum format = img.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        entry.texture = GLTexture(levels, format, w, h, bytes);
+
+        auto owner = std::make_shared<DecodedImage>(std::move(img));
+        bool generate = owner->levels.size() < static_cast<size_t>(levels);
+        auto *raw = &entry;
+        for (size_t i = 0; i < owner->levels.size(); ++i) {
+            bool last = i + 1 == owner->levels.size();
+            auto level = owner->levels[i];
+            TextureUpload upload{
+                .texture = entry.texture.get(),
+                .level = static_cast<GLint>(i),
+                .width = std::max(1, w >> i),
+                .height = std::max(1, h >> i),
+                // aliasing constructor, keeps the whole decoded image alive until uploaded
+                .pixels = std::shared_ptr<const void>(owner, level.data()),
+                .size = level.size(),
+            };
+            if (last)
+                upload.onUploaded = [raw, generate](GLuint t) {
+                    if (generate)
+                        glGenerateTextureMipmap(t);
+                    raw->ready = true;
+                };
+            TextureUploadQueue::get().enqueue(std::move(upload));
+        }
+    }
+
+    // Moves finished decodes on to the upload queue, failed ones are dropped from the cache.
+    void finishDecodes() {
+        std::erase_if(pending, [this](PendingDecode &p) {
+            if (p.image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+            try {
+                uploadDecoded(*p.entry, p.image.get());
+                spdlog::debug("texture decoded: {} ({} KiB)", p.key,
+                              p.entry->texture.bytes() / 1024);
+            } catch (const std::exception &e) {
+                spdlog::error("Failed to decode texture {}: {}", p.key, e.what());
+                textures.erase(p.key);
+            }
+            return true;
+        });
+    }
+
+  public:
+    static TextureManager &get() {
+        static TextureManager instance;
+        return instance;
+    }
+
+    /**
+     * \brief Returns a handle to the texture at `path`, loading it only if no texture with the same
+     * path and parameters is cached. `.ktx2` files are uploaded as stored, anything else is
+     * decoded on the job system and stays not ready() until its levels are uploaded. Throws
+     * std::runtime_error if the file can't be read, decode errors are only logged.
+     */
+    TextureHandle load(const std::string &path, const TextureParams &params = {}) {
+        auto key = path + (params.srgb ? "|srgb" : "") + (params.premultiply ? "|premul" : "") +
+                   "|" + mip_filter_to_string(params.mipFilter);
+        auto samplerId = sampler(params.sampler);
+
+        auto it = textures.find(key);
+        if (it != textures.end()) {
+            stats.hits++;
+            it->second->lastUsed = frame;
+            return {it->second, samplerId, &frame};
+        }
+
+        auto entry = std::make_shared<ManagedTexture>();
+        auto *raw = entry.get();
+        if (path.ends_with(".ktx2")) {
+            entry->texture = loadKtx2Texture(path, [raw](GLuint) { raw->ready = true; });
+        } else {
+            DecodeOptions opts{params.srgb, params.premultiply, true, params.mipFilter};
+            pending.push_back({key, entry,
+                               JobSystem::get().submit([asset = load_asset(path), opts]() {
+                                   return decode_image(asset, opts);
+                               })});
+        }
+        entry->lastUsed = frame;
+
+        stats.loads++;
+        textures[key] = entry;
+        spdlog::debug("texture loaded: {}", key);
+        return {entry, samplerId, &frame};
+    }
+
+    /**
+     * \brief Queues uploads for finished decodes, then evicts unused textures, least recently
+     * used first, until the cache fits in `budget` bytes. Call once per frame, textures still
+     * referenced by a handle or being decoded are never evicted.
+     */
+    void collect(size_t budget) {
+        frame++;
+        finishDecodes();
+
+        size_t total = 0;
+        std::vector<std::pair<uint64_t, const std::string *>> unused;
+        for (auto &[key, tex] : textures) {
+            total += tex->texture.bytes();
+            if (tex.use_count() == 1)
+                unused.emplace_back(tex->lastUsed, &key);
+        }
+
+        std::vector<std::string> evict;
+        if (total > budget) {
+            std::sort(unused.begin(), unused.end());
+            for (auto &[lastUsed, key] : unused) {
+                if (total <= budget)
+                    break;
+                total -= textures.at(*key)->texture.bytes();
+                evict.push_back(*key);
+            }
+        }
+        for (auto &key : evict) {
+            spdlog::debug("texture evicted: {}", key);
+            textures.erase(key);
+        }
+
+        stats.evictions += evict.size();
+        stats.textures = textures.size();
+        stats.unused = unused.size() - evict.size();
+        stats.bytes = total;
+        stats.decoding = pending.size();
+    }
+
+    const TextureStats &getStats() const { return stats; }
+
+    /**
+     * \brief Drops every cached texture, pending decode and sampler. Main calls it at shutdown
+     * while the context is still alive, textures somebody else still holds are deleted when they
+     * let go of them.
+     */
+    void clear() {
+        pending.clear();
+        textures.clear();
+        for (auto &[desc, id] : samplers)
+            glDeleteSamplers(1, &id);
+        samplers.clear();
+        stats = {};
+    }
+
+    ~TextureManager() {
+        for (auto &[desc, id] : samplers)
+            glDeleteSamplers(1, &id);
+    }
+
+  private:
+    // constructs the upload queue and job system first so they are still alive when cached
+    // textures cancel their pending uploads during static destruction
+    TextureManager() {
+        TextureUploadQueue::get();
+        JobSystem::get();
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include "buffer.hpp"
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+/**
+ * \brief One sub-image to copy into a texture. `pixels` is kept alive until the copy into the
+ * staging ring has been made, so it can own the decoder's allocation directly.
+ */
+struct TextureUpload {
+    GLuint texture = 0;
+    GLint level = 0;
+    GLint x = 0, y = 0;
+    GLsizei width = 0, height = 0;
+    GLenum format = GL_RGBA; // the internal format for compressed uploads
+    GLenum type = GL_UNSIGNED_BYTE;
+    bool compressed = false; // block compressed data, uploaded as-is
+    std::shared_ptr<const void> pixels;
+    size_t size = 0; // bytes in `pixels`, tightly packed rows
+    // runs once the upload has been issued, GL orders it after the copy so e.g. mip generation
+    // can be queued from here
+    std::function<void(GLuint)> onUploaded;
+};
+
+/**
+ * \brief Streams texture data to the GPU through a persistently mapped pixel unpack buffer, so
+ * glTextureSubImage2D reads from GPU-visible memory instead of blocking on client memory.
+ * Uploads are queued and drained by process() once per frame up to a byte budget, and each
+ * frame's staging range is fenced so it is reused only after the GPU has consumed it.
+ */
+class TextureUploadQueue {
+  public:
+    static constexpr size_t RING_SIZE = 32 * 1024 * 1024;
+    static constexpr size_t ALIGNMENT = 16;
+
+    struct Stats {
+        size_t pending = 0; // uploads still waiting for budget or ring space
+        size_t bytesLastFrame = 0;
+        size_t ringInUse = 0; // staging bytes the GPU may still be reading
+        size_t uploaded = 0;  // total uploads issued
+    };
+
+  private:
+    struct Fenced {
+        GLsync fence;
+        size_t bytes; // ring bytes released when the fence signals, wrap padding included
+    };
+
+    std::unique_ptr<GLBuffer<std::byte>> ring;
+    std::byte *mapped = nullptr;
+    size_t head = 0; // next write offset
+    size_t used = 0; // bytes from the oldest in-flight range up to head
+    std::deque<Fenced> inFlight;
+    std::deque<TextureUpload> queue;
+    Stats stats;
+
+    static constexpr GLbitfield FLAGS =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    void createRing() {
+        ring = std::make_unique<GLBuffer<std::byte>>();
+        ring->allocate(RING_SIZE, FLAGS);
+        mapped =
+            static_cast<std::byte *>(glMapNamedBufferRange(ring->get(), 0, RING_SIZE, FLAGS));
+        if (!mapped)
+            throw std::runtime_error("Failed to map texture upload ring");
+    }
+
+    void retire() {
+        while (!inFlight.empty()) {
+            auto status = glClientWaitSync(inFlight.front().fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(inFlight.front().fence);
+            used -= inFlight.front().bytes;
+            inFlight.pop_front();
+        }
+    }
+
+    // Reserves `size` bytes in the ring, returns false if the GPU still holds too much of it.
+    bool reserve(size_t size, size_t &offset, size_t &consumed) {
+        if (used == 0)
+            head = 0; // nothing is in flight, so don't charge wrap padding for an empty ring
+        size_t start = (head + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (start + size > RING_SIZE)
+            start = 0; // wrap, the tail end of the ring is wasted until this range retires
+        size_t padding = (start >= head ? start - head : RING_SIZE - head);
+        if (used + padding + size > RING_SIZE)
+            return false;
+        offset = start;
+        consumed = padding + size;
+        head = start + size;
+        used += consumed;
+        return true;
+    }
+
+    static void issue(const TextureUpload &u, const void *pixels) {
+        if (u.compressed)
+            glCompressedTextureSubImage2D(u.texture, u.level, u.x, u.y, u.width, u.height,
+                                          u.format, static_cast<GLsizei>(u.size), pixels);
+        else
+            glTextureSubImage2D(u.texture, u.level, u.x, u.y, u.width, u.height, u.format, u.type,
+                                pixels);
+    }
+
+    // Uploads that don't fit the ring at all go straight from client memory.
+    void uploadDirect(const TextureUpload &u) {
+        spdlog::warn("texture upload of {} bytes exceeds the staging ring, uploading directly",
+                     u.size);
+        issue(u, u.pixels.get());
+    }
+
+  public:
+    static TextureUploadQueue &get() {
+        static TextureUploadQueue instance;
+        return instance;
+    }
+
+    void enqueue(TextureUpload upload) { queue.push_back(std::move(upload)); }
+
+    // Drops queued uploads for a texture that is about to be deleted.
+    void cancel(GLuint texture) {
+        std::erase_if(queue, [texture](const TextureUpload &u) { return u.texture == texture; });
+    }
+
+    /**
+     * \brief Issues queued uploads in order until `budget` bytes have been copied this frame. The
+     * first upload always goes through so a single texture larger than the budget still lands.
+     */
+    void process(size_t budget) {
+        stats.bytesLastFrame = 0;
+        if (queue.empty() && inFlight.empty()) {
+            stats.pending = 0;
+            stats.ringInUse = 0;
+            return;
+        }
+        if (!ring)
+            createRing();
+        retire();
+
+        size_t frameBytes = 0;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->get());
+        while (!queue.empty()) {
+            auto &u = queue.front();
+            if (stats.bytesLastFrame > 0 && stats.bytesLastFrame + u.size > budget)
+                break;
+
+            if (u.size > RING_SIZE) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                uploadDirect(u);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->get());
+            } else {
+                size_t offset, consumed;
+                if (!reserve(u.size, offset, consumed))
+                    break; // ring is full, try again once older frames retire
+                std::memcpy(mapped + offset, u.pixels.get(), u.size);
+                issue(u, reinterpret_cast<const void *>(offset));
+                frameBytes += consumed;
+            }
+
+            stats.bytesLastFrame += u.size;
+            stats.uploaded++;
+            if (u.onUploaded)
+                u.onUploaded(u.texture);
+            queue.pop_front();
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        if (frameBytes > 0)
+            inFlight.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameBytes});
+        stats.pending = queue.size();
+        stats.ringInUse = used;
+    }
+
+    bool idle() const { return queue.empty(); }
+    const Stats &getStats() const { return stats; }
+
+    /**
+     * \brief Drops the queued uploads and frees the staging ring. Main calls it at shutdown while
+     * the context is still alive, after TextureManager::clear(). GL keeps the buffer's storage
+     * until commands still reading from it have finished.
+     */
+    void shutdown() {
+        queue.clear();
+        for (auto &f : inFlight)
+            glDeleteSync(f.fence);
+        inFlight.clear();
+        if (ring) {
+            glUnmapNamedBuffer(ring->get());
+            ring.reset();
+            mapped = nullptr;
+        }
+        head = 0;
+        used = 0;
+        stats.pending = 0;
+        stats.ringInUse = 0;
+    }
+
+    ~TextureUploadQueue() {
+        for (auto &f : inFlight)
+            glDeleteSync(f.fence);
+        if (ring)
+            glUnmapNamedBuffer(ring->get());
+    }
+
+  private:
+    TextureUploadQueue() = default;
+};
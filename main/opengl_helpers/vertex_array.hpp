@@ -14,6 +14,10 @@ class GLVertexArray {
         glVertexArrayVertexBuffer(id, binding, buffer.get(), offset, stride);
     }
 
+    template <typename T> void setElementBuffer(const GLBuffer<T> &buffer) {
+        glVertexArrayElementBuffer(id, buffer.get());
+    }
+
     void setAttribFormat(GLuint attribIndex, GLint size, GLenum type,
                          GLboolean normalized = GL_FALSE, GLuint relativeOffset = 0) {
         glVertexArrayAttribFormat(id, attribIndex, size, type, normalized, relativeOffset);
@@ -21,6 +25,15 @@ class GLVertexArray {
         glVertexArrayAttribBinding(id, attribIndex, attribIndex);
     }
 
+    // Points an attribute at a different binding than its own index, for interleaved buffers.
+    void setAttribBinding(GLuint attribIndex, GLuint binding) {
+        glVertexArrayAttribBinding(id, attribIndex, binding);
+    }
+
+    void setBindingDivisor(GLuint binding, GLuint divisor) {
+        glVertexArrayBindingDivisor(id, binding, divisor);
+    }
+
     void bind() const { glBindVertexArray(id); }
 
     ~GLVertexArray() { glDeleteVertexArrays(1, &id); }
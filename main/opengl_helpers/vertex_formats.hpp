@@ -0,0 +1,93 @@
+#pragma once
+#include "shader_manager.hpp"
+#include "vertex_layout.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/gtc/packing.hpp>
+
+// Compact attribute encodings. Each type carries its own AttribFormat, so using one as a vertex
+// struct field is all it takes for MAKE_VERTEX_LAYOUT to set up the right GL format.
+
+// Four half floats, the 4th one pads positions to 8 bytes and reads as w = 1.
+struct half4 {
+    uint16_t v[4];
+
+    static half4 from(const glm::vec3 &p) {
+        return {{glm::packHalf1x16(p.x), glm::packHalf1x16(p.y), glm::packHalf1x16(p.z),
+                 glm::packHalf1x16(1.0f)}};
+    }
+};
+
+struct half2 {
+    uint16_t v[2];
+
+    static half2 from(const glm::vec2 &p) {
+        return {{glm::packHalf1x16(p.x), glm::packHalf1x16(p.y)}};
+    }
+};
+
+// [0, 1] per channel, for colors.
+struct unorm8x4 {
+    uint8_t v[4];
+
+    static unorm8x4 from(const glm::vec4 &c) {
+        auto q = [](float f) {
+            return static_cast<uint8_t>(std::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f);
+        };
+        return {{q(c.x), q(c.y), q(c.z), q(c.w)}};
+    }
+};
+
+// [0, 1] per channel, for texture coordinates.
+struct unorm16x2 {
+    uint16_t v[2];
+
+    static unorm16x2 from(const glm::vec2 &uv) {
+        auto q = [](float f) {
+            return static_cast<uint16_t>(std::clamp(f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        };
+        return {{q(uv.x), q(uv.y)}};
+    }
+};
+
+/**
+ * \brief Unit vector in 4 bytes: octahedral mapping stored as two snorm16. Decode in GLSL with
+ * octDecode() from #include "octahedral.glsl".
+ */
+struct octnormal {
+    int16_t v[2];
+
+    static octnormal from(glm::vec3 n) {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 e(n.x, n.y);
+        if (n.z < 0.0f) {
+            auto signNotZero = [](float f) { return f >= 0.0f ? 1.0f : -1.0f; };
+            e = glm::vec2((1.0f - std::abs(n.y)) * signNotZero(n.x),
+                          (1.0f - std::abs(n.x)) * signNotZero(n.y));
+        }
+        auto q = [](float f) {
+            return static_cast<int16_t>(std::round(std::clamp(f, -1.0f, 1.0f) * 32767.0f));
+        };
+        return {{q(e.x), q(e.y)}};
+    }
+};
+
+ATTRIB_FORMAT(half4, 4, GL_HALF_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(half2, 2, GL_HALF_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(unorm8x4, 4, GL_UNSIGNED_BYTE, GL_TRUE, false);
+ATTRIB_FORMAT(unorm16x2, 2, GL_UNSIGNED_SHORT, GL_TRUE, false);
+ATTRIB_FORMAT(octnormal, 2, GL_SHORT, GL_TRUE, false);
+
+inline constexpr const char *OCTAHEDRAL_GLSL = R"(
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+)";
+
+inline const bool octahedralIncludeRegistered =
+    (ShaderManager::get().addInclude("octahedral.glsl", OCTAHEDRAL_GLSL), true);
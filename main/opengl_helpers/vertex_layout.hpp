@@ -0,0 +1,184 @@
+#pragma once
+#include "vertex_array.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * \brief How a C++ field type is fed to a vertex attribute. Specialize for any new field type.
+ */
+template <typename T> struct AttribFormat;
+
+#define ATTRIB_FORMAT(TYPE, SIZE, GL_TYPE, NORMALIZED, INTEGER)                                    \
+    template <> struct AttribFormat<TYPE> {                                                        \
+        static constexpr GLint size = SIZE;                                                        \
+        static constexpr GLenum type = GL_TYPE;                                                    \
+        static constexpr GLboolean normalized = NORMALIZED;                                        \
+        static constexpr bool integer = INTEGER;                                                   \
+    }
+
+ATTRIB_FORMAT(float, 1, GL_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(glm::vec2, 2, GL_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(glm::vec3, 3, GL_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(glm::vec4, 4, GL_FLOAT, GL_FALSE, false);
+ATTRIB_FORMAT(int32_t, 1, GL_INT, GL_FALSE, true);
+ATTRIB_FORMAT(uint32_t, 1, GL_UNSIGNED_INT, GL_FALSE, true);
+ATTRIB_FORMAT(glm::ivec2, 2, GL_INT, GL_FALSE, true);
+ATTRIB_FORMAT(glm::ivec4, 4, GL_INT, GL_FALSE, true);
+ATTRIB_FORMAT(glm::uvec2, 2, GL_UNSIGNED_INT, GL_FALSE, true);
+ATTRIB_FORMAT(glm::uvec4, 4, GL_UNSIGNED_INT, GL_FALSE, true);
+
+struct VertexAttrib {
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    bool integer;
+    GLuint offset;
+    GLuint binding;
+};
+
+template <typename T> constexpr VertexAttrib makeAttrib(GLuint location, size_t offset) {
+    return {location,
+            AttribFormat<T>::size,
+            AttribFormat<T>::type,
+            AttribFormat<T>::normalized,
+            AttribFormat<T>::integer,
+            static_cast<GLuint>(offset),
+            0};
+}
+
+/**
+ * \brief Full description of the vertex input of a VAO: every attribute plus the stride and
+ * divisor of each buffer binding. Built at compile time from one or more vertex structs.
+ */
+struct VertexLayout {
+    static constexpr size_t MAX_ATTRIBS = 16;
+    static constexpr size_t MAX_BINDINGS = 4;
+
+    std::array<VertexAttrib, MAX_ATTRIBS> attribs{};
+    size_t attribCount = 0;
+    std::array<GLuint, MAX_BINDINGS> strides{};
+    std::array<GLuint, MAX_BINDINGS> divisors{};
+    size_t bindingCount = 0;
+
+    // FNV-1a over every field that ends up in GL state, so equal layouts share one VAO
+    constexpr uint64_t hash() const {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](uint64_t v) {
+            h ^= v;
+            h *= 1099511628211ull;
+        };
+        for (size_t i = 0; i < attribCount; ++i) {
+            const auto &a = attribs[i];
+            mix(a.location);
+            mix(a.size);
+            mix(a.type);
+            mix(a.normalized);
+            mix(a.integer);
+            mix(a.offset);
+            mix(a.binding);
+        }
+        for (size_t b = 0; b < bindingCount; ++b) {
+            mix(strides[b]);
+            mix(divisors[b]);
+        }
+        return h;
+    }
+};
+
+/**
+ * \brief Per vertex struct description, generated by MAKE_VERTEX_LAYOUT.
+ */
+template <typename V> struct VertexLayoutTraits;
+
+#define VERTEX_ATTRIB(field, location)                                                             \
+    makeAttrib<decltype(Self::field)>(location, offsetof(Self, field)),
+
+#define MAKE_VERTEX_LAYOUT(TYPE, DIVISOR, FIELDS_MACRO)                                            \
+    template <> struct VertexLayoutTraits<TYPE> {                                                  \
+        using Self = TYPE;                                                                         \
+        static constexpr GLuint divisor = DIVISOR;                                                 \
+        static constexpr VertexAttrib attribs[] = {FIELDS_MACRO(VERTEX_ATTRIB)};                   \
+    }
+
+/**
+ * \brief Combines vertex structs into one layout, the Nth struct is read from buffer binding N.
+ * Use the same order when attaching buffers with GLVertexArray::setVertexBuffer.
+ */
+template <typename... Vs> constexpr VertexLayout makeVertexLayout() {
+    static_assert(sizeof...(Vs) <= VertexLayout::MAX_BINDINGS, "too many vertex bindings");
+    VertexLayout layout;
+    // an empty layout is valid, for vertex pulling or attributeless draws
+    if constexpr (sizeof...(Vs) > 0) {
+        auto add = [&layout]<typename V>() {
+            auto binding = static_cast<GLuint>(layout.bindingCount++);
+            layout.strides[binding] = sizeof(V);
+            layout.divisors[binding] = VertexLayoutTraits<V>::divisor;
+            for (auto attrib : VertexLayoutTraits<V>::attribs) {
+                attrib.binding = binding;
+                layout.attribs[layout.attribCount++] = attrib;
+            }
+        };
+        (add.template operator()<Vs>(), ...);
+    }
+    return layout;
+}
+
+inline void applyVertexLayout(GLVertexArray &vao, const VertexLayout &layout) {
+    for (size_t i = 0; i < layout.attribCount; ++i) {
+        const auto &a = layout.attribs[i];
+        if (a.integer)
+            glVertexArrayAttribIFormat(vao.get(), a.location, a.size, a.type, a.offset);
+        else
+            glVertexArrayAttribFormat(vao.get(), a.location, a.size, a.type, a.normalized,
+                                      a.offset);
+        glEnableVertexArrayAttrib(vao.get(), a.location);
+        vao.setAttribBinding(a.location, a.binding);
+    }
+    for (size_t b = 0; b < layout.bindingCount; ++b)
+        vao.setBindingDivisor(static_cast<GLuint>(b), layout.divisors[b]);
+}
+
+/**
+ * \brief Hands out one shared VAO per distinct vertex layout. Everything drawing with the same
+ * layout reuses it and only swaps buffer bindings.
+ */
+class VertexArrayCache {
+  private:
+    std::unordered_map<uint64_t, std::shared_ptr<GLVertexArray>> vaos;
+
+  public:
+    static VertexArrayCache &get() {
+        static VertexArrayCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<GLVertexArray> acquire(const VertexLayout &layout) {
+        auto key = layout.hash();
+        auto it = vaos.find(key);
+        if (it != vaos.end())
+            return it->second;
+
+        auto vao = std::make_shared<GLVertexArray>();
+        applyVertexLayout(*vao, layout);
+        vaos[key] = vao;
+        return vao;
+    }
+
+    template <typename... Vs> std::shared_ptr<GLVertexArray> acquire() {
+        static constexpr VertexLayout layout = makeVertexLayout<Vs...>();
+        return acquire(layout);
+    }
+
+    size_t size() const { return vaos.size(); }
+
+    // Deletes the cached VAOs, at shutdown while the context is still alive. Ones still held
+    // elsewhere are deleted when they are released.
+    void clear() { vaos.clear(); }
+
+  private:
+    VertexArrayCache() = default;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gl_debug.h"
 #include "graphics.h"
 #include "main.h"
 #include "module_registry.h"
@@ -21,6 +22,11 @@ void overlay_module(Registry &reg, State &ctx) {
         ig::Begin("main", NULL, flags);
         ig::PopStyleVar(2);
         ig::Text("%.1f FPS", ImGui::GetIO().Framerate);
+        if (ctx.gl_profile == GLProfile::debug) {
+            auto &gl_stats = gl_debug_stats();
+            ig::Text("GL perf warnings: %u/frame (%zu unique)", gl_stats.perf_last_frame,
+                     gl_stats.unique_messages);
+        }
         if (ctx.display_debug) {
             ig::Spacing();
             ig::Text(state_to_string(ctx).c_str());
@@ -0,0 +1,281 @@
+#include "post_process.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <span>
+
+static constexpr const char *POST_SHADER_SOURCE = R"(
+#version 450 core
+#define MAX_RADIUS 32
+
+#if defined(BLUR_H) || defined(BLUR_V)
+#define TILE 128
+layout(local_size_x = TILE) in;
+shared vec4 tile[TILE + 2 * MAX_RADIUS];
+#else
+layout(local_size_x = 8, local_size_y = 8) in;
+#endif
+
+layout(binding = 0) uniform sampler2D uSource;
+layout(binding = 1) uniform sampler2D uBloom;
+layout(rgba16f, binding = 0) uniform writeonly image2D uTarget;
+
+// the part of each target in use, their allocations can be larger
+uniform vec2 uSize;
+uniform vec2 uSourceSize;
+uniform vec2 uBloomSize;
+uniform int uRadius;
+uniform vec4 uWeights[(MAX_RADIUS + 4) / 4];
+uniform float uThreshold;
+uniform float uBloomIntensity;
+uniform float uExposure;
+uniform float uSaturation;
+uniform float uContrast;
+
+// Maps the target's texel centers onto the used part of `tex`, which averages 2x2 texels when the
+// target is half size. Clamped so filtering never reaches past the used part.
+vec4 sampleUsed(sampler2D tex, vec2 used, ivec2 p) {
+    vec2 at = (vec2(clamp(p, ivec2(0), ivec2(uSize) - 1)) + 0.5) * (used / uSize);
+    at = clamp(at, vec2(0.5), used - 0.5);
+    return textureLod(tex, at / vec2(textureSize(tex, 0)), 0.0);
+}
+
+vec4 load(ivec2 p) {
+    vec4 c = sampleUsed(uSource, uSourceSize, p);
+#ifdef BRIGHT
+    float peak = max(c.r, max(c.g, c.b));
+    c.rgb *= max(peak - uThreshold, 0.0) / max(peak, 1e-4);
+#endif
+    return c;
+}
+
+float weight(int k) { return uWeights[k >> 2][k & 3]; }
+
+void main() {
+    ivec2 size = ivec2(uSize);
+#if defined(BLUR_H) || defined(BLUR_V)
+    int i = int(gl_LocalInvocationID.x);
+    int along = int(gl_WorkGroupID.x) * TILE + i;
+#ifdef BLUR_H
+    ivec2 pixel = ivec2(along, gl_WorkGroupID.y);
+    ivec2 axis = ivec2(1, 0);
+#else
+    ivec2 pixel = ivec2(gl_WorkGroupID.y, along);
+    ivec2 axis = ivec2(0, 1);
+#endif
+    // the group's row plus the radius on both sides, each texel is fetched once
+    ivec2 first = pixel - axis * (i + uRadius);
+    for (int j = i; j < TILE + 2 * uRadius; j += TILE)
+        tile[j] = load(first + axis * j);
+    barrier();
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    vec4 c = tile[i + uRadius] * weight(0);
+    for (int k = 1; k <= uRadius; ++k)
+        c += (tile[i + uRadius - k] + tile[i + uRadius + k]) * weight(k);
+#else
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+    vec4 c = load(pixel);
+#endif
+
+#ifdef BLOOM
+    c.rgb += sampleUsed(uBloom, uBloomSize, pixel).rgb * uBloomIntensity;
+#endif
+#ifdef TONEMAP
+    // ACES fit by Krzysztof Narkowicz
+    vec3 x = c.rgb * uExposure;
+    c.rgb = clamp(x * (2.51 * x + 0.03) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+#endif
+#ifdef GRADE
+    float luma = dot(c.rgb, vec3(0.2126, 0.7152, 0.0722));
+    c.rgb = mix(vec3(luma), c.rgb, uSaturation);
+    c.rgb = max((c.rgb - 0.5) * uContrast + 0.5, 0.0);
+#endif
+    imageStore(uTarget, pixel, c);
+}
+)";
+
+static constexpr GLuint BLUR_TILE = 128;
+static constexpr GLuint POINTWISE_TILE = 8;
+
+static UniformHandle active_uniform(const GLProgram &program, const char *name) {
+    // variants compile out the uniforms they don't use, that's expected here
+    auto &uniforms = program.activeUniforms();
+    auto it = uniforms.find(std::string_view(name));
+    return it == uniforms.end() ? UniformHandle{} : it->second;
+}
+
+PostProcessChain::PostProcessChain() {
+    glCreateSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+PostProcessChain::~PostProcessChain() { glDeleteSamplers(1, &sampler); }
+
+PostProcessChain::Variant &PostProcessChain::variant(ShaderVariantKey<PostFeatures> key) {
+    auto it = variants.find(key.bits);
+    if (it != variants.end())
+        return it->second;
+
+    auto cs = ShaderManager::get().getVariant("post_compute", GL_COMPUTE_SHADER,
+                                              POST_SHADER_SOURCE, key);
+    Variant v;
+    v.program = std::make_unique<GLProgram>(*cs);
+    v.size = active_uniform(*v.program, "uSize");
+    v.source_size = active_uniform(*v.program, "uSourceSize");
+    v.bloom_size = active_uniform(*v.program, "uBloomSize");
+    v.radius = active_uniform(*v.program, "uRadius");
+    v.weights = active_uniform(*v.program, "uWeights");
+    v.threshold = active_uniform(*v.program, "uThreshold");
+    v.bloom_intensity = active_uniform(*v.program, "uBloomIntensity");
+    v.exposure = active_uniform(*v.program, "uExposure");
+    v.saturation = active_uniform(*v.program, "uSaturation");
+    v.contrast = active_uniform(*v.program, "uContrast");
+    return variants.emplace(key.bits, std::move(v)).first->second;
+}
+
+void PostProcessChain::dispatch(ShaderVariantKey<PostFeatures> key, const RenderTarget &source,
+                                const RenderTarget &target, const std::string &name, int radius,
+                                const post_config &cfg) {
+    auto &v = variant(key);
+    auto &timer = timers[name];
+    if (!timer)
+        timer = std::make_unique<GpuTimer<>>();
+    timer->begin();
+
+    bool blur = key.has(PostFeatures::BlurH) || key.has(PostFeatures::BlurV);
+    if (blur) {
+        // normalized gaussian with the radius at 3 sigma, packed four to a vec4
+        std::array<glm::vec4, (MAX_RADIUS + 4) / 4> weights{};
+        float sigma = std::max(radius / 3.0f, 0.5f), sum = 0.0f;
+        for (int k = 0; k <= radius; ++k) {
+            float w = std::exp(-0.5f * k * k / (sigma * sigma));
+            weights[k / 4][k % 4] = w;
+            sum += k == 0 ? w : 2.0f * w;
+        }
+        for (auto &w : weights)
+            w /= sum;
+        v.program->set(v.radius, static_cast<GLint>(radius));
+        v.program->set(v.weights, std::span<const glm::vec4>(weights));
+    }
+    v.program->set(v.threshold, static_cast<float>(cfg.bloom_threshold));
+    v.program->set(v.bloom_intensity, static_cast<float>(cfg.bloom_intensity));
+    v.program->set(v.exposure, static_cast<float>(cfg.exposure));
+    v.program->set(v.saturation, static_cast<float>(cfg.saturation));
+    v.program->set(v.contrast, static_cast<float>(cfg.contrast));
+
+    auto size = [](const RenderTarget &t) {
+        return glm::vec2(static_cast<float>(t.width()), static_cast<float>(t.height()));
+    };
+    v.program->set(v.size, size(target));
+    v.program->set(v.source_size, size(source));
+    if (key.has(PostFeatures::Bloom))
+        v.program->set(v.bloom_size, size(*bloom[1]));
+
+    glBindTextureUnit(0, source.colorTexture());
+    glBindSampler(0, sampler);
+    if (key.has(PostFeatures::Bloom)) {
+        glBindTextureUnit(1, bloom[1]->colorTexture());
+        glBindSampler(1, sampler);
+    }
+    glBindImageTexture(0, target.colorTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    v.program->use();
+
+    auto w = static_cast<GLuint>(target.width()), h = static_cast<GLuint>(target.height());
+    if (key.has(PostFeatures::BlurH))
+        glDispatchCompute((w + BLUR_TILE - 1) / BLUR_TILE, h, 1);
+    else if (key.has(PostFeatures::BlurV))
+        glDispatchCompute((h + BLUR_TILE - 1) / BLUR_TILE, w, 1);
+    else
+        glDispatchCompute((w + POINTWISE_TILE - 1) / POINTWISE_TILE,
+                          (h + POINTWISE_TILE - 1) / POINTWISE_TILE, 1);
+    // read next by the following dispatch or blitted to the window
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    timer->end();
+    stats.dispatches++;
+    stats.timings.push_back({name, timer->ms()});
+}
+
+void PostProcessChain::release() {
+    stats = {};
+    bloom[0].reset();
+    bloom[1].reset();
+    ping[0].reset();
+    ping[1].reset();
+}
+
+const RenderTarget &PostProcessChain::run(const RenderTarget &scene, const post_config &cfg) {
+    stats = {};
+    if (!enabled(cfg)) {
+        release();
+        return scene;
+    }
+
+    auto acquire = [](std::shared_ptr<RenderTarget> &slot, GLsizei w, GLsizei h) {
+        RenderTargetPool::get().fit(slot, {std::max(w, 1), std::max(h, 1), GL_RGBA16F, 0});
+        return slot.get();
+    };
+
+    // bloom is taken from the scene as rendered, at half size
+    if (cfg.bloom) {
+        auto *bright = acquire(bloom[0], scene.width() / 2, scene.height() / 2);
+        auto *blurred = acquire(bloom[1], scene.width() / 2, scene.height() / 2);
+        dispatch(ShaderVariantKey<PostFeatures>{PostFeatures::BlurH} | PostFeatures::Bright,
+                 scene, *bright, "bloom_h", BLOOM_RADIUS, cfg);
+        dispatch(PostFeatures::BlurV, *bright, *blurred, "bloom_v", BLOOM_RADIUS, cfg);
+    } else {
+        bloom[0].reset();
+        bloom[1].reset();
+    }
+
+    struct Step {
+        PostFeatures feature;
+        const char *name;
+        bool pointwise;
+    };
+    std::vector<Step> steps;
+    if (cfg.blur) {
+        steps.push_back({PostFeatures::BlurH, "blur_h", false});
+        steps.push_back({PostFeatures::BlurV, "blur_v", false});
+    }
+    if (cfg.bloom)
+        steps.push_back({PostFeatures::Bloom, "bloom", true});
+    if (cfg.tonemap)
+        steps.push_back({PostFeatures::Tonemap, "tonemap", true});
+    if (cfg.grade)
+        steps.push_back({PostFeatures::Grade, "grade", true});
+    stats.effects = cfg.blur + cfg.bloom + cfg.tonemap + cfg.grade;
+
+    int radius = std::clamp(cfg.blur_radius, 1, MAX_RADIUS);
+    const RenderTarget *current = &scene;
+    size_t next = 0;
+    for (size_t i = 0; i < steps.size();) {
+        ShaderVariantKey<PostFeatures> key = steps[i].feature;
+        std::string name = steps[i].name;
+        // a pointwise effect only needs the pixel the dispatch is about to write
+        for (++i; cfg.fuse && i < steps.size() && steps[i].pointwise; ++i) {
+            key = key | steps[i].feature;
+            name += '+';
+            name += steps[i].name;
+            stats.fused++;
+        }
+        auto *target = acquire(ping[next], scene.width(), scene.height());
+        dispatch(key, *current, *target, name, radius, cfg);
+        current = target;
+        next ^= 1;
+    }
+    // a chain of one dispatch doesn't need the second target, the pool can have it back
+    if (stats.dispatches - (cfg.bloom ? 2 : 0) < 2)
+        ping[1].reset();
+    glBindSampler(0, 0);
+    glBindSampler(1, 0);
+    return *current;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "opengl_helpers/gpu_timer.hpp"
+#include "opengl_helpers/program.hpp"
+#include "opengl_helpers/render_target.hpp"
+#include "opengl_helpers/shader_manager.hpp"
+#include "settings.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class PostFeatures : uint32_t {
+    // separable gaussian along one axis, the row is tiled through shared memory
+    BlurH = 1 << 0,
+    BlurV = 1 << 1,
+    // keeps only what is brighter than the threshold, applied as texels are loaded
+    Bright = 1 << 2,
+    // the rest only look at the pixel being written, so they can finish any dispatch
+    Bloom = 1 << 3,
+    Tonemap = 1 << 4,
+    Grade = 1 << 5,
+};
+
+#define POST_FEATURES(X)                                                                           \
+    X(PostFeatures::BlurH, "BLUR_H")                                                               \
+    X(PostFeatures::BlurV, "BLUR_V")                                                               \
+    X(PostFeatures::Bright, "BRIGHT")                                                              \
+    X(PostFeatures::Bloom, "BLOOM")                                                                \
+    X(PostFeatures::Tonemap, "TONEMAP")                                                            \
+    X(PostFeatures::Grade, "GRADE")
+
+MAKE_SHADER_FEATURES(PostFeatures, POST_FEATURES);
+
+struct PostDispatchStats {
+    std::string name; // effects that ran in the dispatch, joined with '+'
+    double gpu_ms = 0.0;
+};
+
+struct PostProcessStats {
+    size_t effects = 0;
+    size_t dispatches = 0;
+    size_t fused = 0; // effects that ran at the end of another one's dispatch
+    std::vector<PostDispatchStats> timings;
+};
+
+/**
+ * \brief Runs the enabled post effects over the scene target with compute shaders: bloom, blur,
+ * tonemapping and color grading, in that order. Every dispatch is a variant of one shader, so a
+ * pointwise effect is fused into the dispatch before it by adding its feature bit. Intermediate
+ * results ping-pong between two pooled half-float targets.
+ */
+class PostProcessChain {
+  private:
+    static constexpr int MAX_RADIUS = 32; // has to match the shader
+    static constexpr int BLOOM_RADIUS = 12;
+
+    struct Variant {
+        std::unique_ptr<GLProgram> program;
+        UniformHandle size, source_size, bloom_size, radius, weights;
+        UniformHandle threshold, bloom_intensity, exposure, saturation, contrast;
+    };
+
+    std::unordered_map<uint32_t, Variant> variants;
+    std::unordered_map<std::string, std::unique_ptr<GpuTimer<>>> timers;
+    std::shared_ptr<RenderTarget> bloom[2];
+    std::shared_ptr<RenderTarget> ping[2];
+    GLuint sampler = 0;
+    PostProcessStats stats;
+
+    Variant &variant(ShaderVariantKey<PostFeatures> key);
+    void dispatch(ShaderVariantKey<PostFeatures> key, const RenderTarget &source,
+                  const RenderTarget &target, const std::string &name, int radius,
+                  const post_config &cfg);
+
+  public:
+    PostProcessChain();
+    ~PostProcessChain();
+
+    static bool enabled(const post_config &cfg) {
+        return cfg.bloom || cfg.blur || cfg.tonemap || cfg.grade;
+    }
+
+    /**
+     * \brief Runs the chain over the color of `scene` and returns the target holding the result,
+     * which stays valid until the next run. Returns `scene` itself if nothing is enabled.
+     */
+    const RenderTarget &run(const RenderTarget &scene, const post_config &cfg);
+    // Hands the intermediate targets back to the pool, for frames the chain doesn't run in.
+    void release();
+    const PostProcessStats &get_stats() const { return stats; }
+
+    PostProcessChain(const PostProcessChain &) = delete;
+    PostProcessChain &operator=(const PostProcessChain &) = delete;
+};
@@ -0,0 +1,169 @@
+#include "qoi.h"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t HEADER_SIZE = 14;
+static constexpr std::array<uint8_t, 8> END_MARKER = {0, 0, 0, 0, 0, 0, 0, 1};
+
+enum : uint8_t {
+    OP_INDEX = 0x00,
+    OP_DIFF = 0x40,
+    OP_LUMA = 0x80,
+    OP_RUN = 0xc0,
+    OP_RGB = 0xfe,
+    OP_RGBA = 0xff,
+    OP_MASK = 0xc0,
+};
+
+struct Pixel {
+    uint8_t r, g, b, a;
+};
+
+static int hash(Pixel p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64; }
+
+static uint32_t read_be32(const uint8_t *p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+static void write_be32(std::vector<std::byte> &out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<std::byte>(v >> shift));
+}
+
+bool is_qoi(std::span<const std::byte> file) {
+    return file.size() >= HEADER_SIZE && std::memcmp(file.data(), "qoif", 4) == 0;
+}
+
+QoiImage qoi_decode(std::span<const std::byte> file, bool flip_y) {
+    if (!is_qoi(file))
+        throw std::runtime_error("not a QOI file");
+    auto *in = reinterpret_cast<const uint8_t *>(file.data());
+    QoiImage img;
+    img.width = read_be32(in + 4);
+    img.height = read_be32(in + 8);
+    if (img.width == 0 || img.height == 0 || uint64_t(img.width) * img.height > (1ull << 28))
+        throw std::runtime_error("QOI image has invalid dimensions");
+
+    img.pixels.resize(size_t(img.width) * img.height * 4);
+    auto *out = reinterpret_cast<uint8_t *>(img.pixels.data());
+
+    std::array<Pixel, 64> seen{};
+    Pixel px{0, 0, 0, 255};
+    size_t pos = HEADER_SIZE;
+    size_t end = file.size() - END_MARKER.size();
+    int run = 0;
+
+    for (uint32_t y = 0; y < img.height; ++y) {
+        uint32_t row = flip_y ? img.height - 1 - y : y;
+        auto *dst = out + size_t(row) * img.width * 4;
+        for (uint32_t x = 0; x < img.width; ++x, dst += 4) {
+            if (run > 0) {
+                run--;
+            } else if (pos < end) {
+                uint8_t op = in[pos++];
+                if (op == OP_RGB) {
+                    px.r = in[pos];
+                    px.g = in[pos + 1];
+                    px.b = in[pos + 2];
+                    pos += 3;
+                } else if (op == OP_RGBA) {
+                    px = {in[pos], in[pos + 1], in[pos + 2], in[pos + 3]};
+                    pos += 4;
+                } else if ((op & OP_MASK) == OP_INDEX) {
+                    px = seen[op];
+                } else if ((op & OP_MASK) == OP_DIFF) {
+                    px.r += ((op >> 4) & 3) - 2;
+                    px.g += ((op >> 2) & 3) - 2;
+                    px.b += (op & 3) - 2;
+                } else if ((op & OP_MASK) == OP_LUMA) {
+                    uint8_t next = in[pos++];
+                    int dg = (op & 0x3f) - 32;
+                    px.r += dg - 8 + ((next >> 4) & 0x0f);
+                    px.g += dg;
+                    px.b += dg - 8 + (next & 0x0f);
+                } else {
+                    run = op & 0x3f;
+                }
+                seen[hash(px)] = px;
+            }
+            std::memcpy(dst, &px, 4);
+        }
+    }
+    if (pos > end)
+        throw std::runtime_error("QOI data is truncated");
+    return img;
+}
+
+std::vector<std::byte> qoi_encode(std::span<const std::byte> rgba, uint32_t width,
+                                  uint32_t height) {
+    if (rgba.size() != size_t(width) * height * 4)
+        throw std::runtime_error("QOI encode: pixel data doesn't match the dimensions");
+
+    std::vector<std::byte> out;
+    out.reserve(HEADER_SIZE + rgba.size() / 2);
+    for (char c : {'q', 'o', 'i', 'f'})
+        out.push_back(static_cast<std::byte>(c));
+    write_be32(out, width);
+    write_be32(out, height);
+    out.push_back(std::byte{4}); // channels
+    out.push_back(std::byte{0}); // sRGB with linear alpha
+    auto emit = [&out](uint8_t v) { out.push_back(static_cast<std::byte>(v)); };
+
+    std::array<Pixel, 64> seen{};
+    Pixel prev{0, 0, 0, 255};
+    int run = 0;
+    auto *in = reinterpret_cast<const uint8_t *>(rgba.data());
+    size_t count = size_t(width) * height;
+
+    for (size_t i = 0; i < count; ++i) {
+        Pixel px;
+        std::memcpy(&px, in + i * 4, 4);
+        if (std::memcmp(&px, &prev, 4) == 0) {
+            run++;
+            if (run == 62 || i == count - 1) {
+                emit(OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            emit(OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        int h = hash(px);
+        if (std::memcmp(&seen[h], &px, 4) == 0) {
+            emit(OP_INDEX | h);
+        } else {
+            seen[h] = px;
+            if (px.a == prev.a) {
+                int8_t dr = px.r - prev.r, dg = px.g - prev.g, db = px.b - prev.b;
+                int8_t dr_dg = dr - dg, db_dg = db - dg;
+                if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                    emit(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                } else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 && db_dg > -9 &&
+                           db_dg < 8) {
+                    emit(OP_LUMA | (dg + 32));
+                    emit((dr_dg + 8) << 4 | (db_dg + 8));
+                } else {
+                    emit(OP_RGB);
+                    emit(px.r);
+                    emit(px.g);
+                    emit(px.b);
+                }
+            } else {
+                emit(OP_RGBA);
+                emit(px.r);
+                emit(px.g);
+                emit(px.b);
+                emit(px.a);
+            }
+        }
+        prev = px;
+    }
+
+    for (auto b : END_MARKER)
+        emit(b);
+    return out;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The "Quite OK Image" format: lossless like PNG but decodes in a single pass without inflate,
+// several times faster. Files follow the spec, so rows are stored top-down.
+
+struct QoiImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::byte> pixels; // RGBA8, tightly packed
+};
+
+bool is_qoi(std::span<const std::byte> file);
+
+/**
+ * \brief Decodes to RGBA8 whatever the channel count in the file. With `flip_y` rows come out
+ * bottom-up as GL expects, at no extra cost. Throws std::runtime_error on malformed input.
+ */
+QoiImage qoi_decode(std::span<const std::byte> file, bool flip_y);
+
+// Encodes RGBA8 pixels given in top-down row order.
+std::vector<std::byte> qoi_encode(std::span<const std::byte> rgba, uint32_t width, uint32_t height);
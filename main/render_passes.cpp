@@ -0,0 +1,77 @@
+#include "render_passes.h"
+#include <bit>
+
+void RenderPassRunner::run(const vector<RenderPass> &passes, GLuint fbo, int width, int height,
+                           const ImVec4 &clear, bool use_cache) {
+    timer.begin();
+    stats = {.passes = passes.size(), .rebuilds = stats.rebuilds, .gpu_ms = timer.ms()};
+
+    // hash of everything the cacheable prefix depends on, which ends at the first pass that
+    // can't be cached or isn't ready to draw
+    uint64_t inputs = hash_combine(uint64_t(width) << 32 | uint32_t(height),
+                                   hash_combine(std::bit_cast<uint32_t>(clear.x),
+                                                std::bit_cast<uint32_t>(clear.y)));
+    inputs = hash_combine(inputs, hash_combine(std::bit_cast<uint32_t>(clear.z),
+                                               std::bit_cast<uint32_t>(clear.w)));
+    size_t prefix = 0;
+    for (; prefix < passes.size() && passes[prefix].inputs; ++prefix) {
+        uint64_t h = passes[prefix].inputs();
+        if (h == 0)
+            break;
+        inputs = hash_combine(inputs, h);
+    }
+
+    // an opaque first pass overwrites every pixel, clearing color underneath it is wasted
+    // bandwidth. One that isn't ready draws nothing though, and depth is always cleared.
+    bool opaque = !passes.empty() && passes[0].opaque && (prefix > 0 || !passes[0].inputs);
+    auto clear_buffers = [&clear, opaque]() {
+        glClearColor(clear.x * clear.w, clear.y * clear.w, clear.z * clear.w, clear.w);
+        glClear(opaque ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    };
+    // a minimized window has nothing to cache into
+    if (!use_cache || width == 0 || height == 0)
+        prefix = 0;
+    stats.cached = prefix;
+
+    size_t next = 0;
+    if (prefix > 0) {
+        // the inputs cover the size, a different target means the old contents are gone
+        auto *previous = cache.get();
+        RenderTargetPool::get().fit(cache, {width, height});
+        bool valid = cache.get() == previous && cached_inputs == inputs;
+        if (!valid) {
+            cache->bind();
+            clear_buffers();
+            for (size_t i = 0; i < prefix; ++i)
+                passes[i].draw();
+            stats.drawn += prefix;
+            stats.rebuilds++;
+            cached_inputs = inputs;
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(0, 0, width, height);
+        }
+        stats.replayed = valid;
+        // the copy covers every pixel, so only depth needs clearing
+        glBlitNamedFramebuffer(cache->get(), fbo, 0, 0, width, height, 0, 0, width, height,
+                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        stats.clear_elided = true;
+        next = prefix;
+    } else {
+        // a pass that isn't ready yet keeps the old output around, it's likely still valid
+        if (!use_cache)
+            invalidate();
+        clear_buffers();
+        stats.clear_elided = opaque;
+    }
+
+    for (size_t i = next; i < passes.size(); ++i)
+        passes[i].draw();
+    stats.drawn += passes.size() - next;
+    timer.end();
+}
+
+void RenderPassRunner::invalidate() {
+    cache.reset();
+    cached_inputs = 0;
+}
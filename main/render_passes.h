@@ -0,0 +1,44 @@
+#pragma once
+
+#include "main.h"
+#include "opengl_helpers/gpu_timer.hpp"
+#include "opengl_helpers/render_target.hpp"
+#include <cstdint>
+#include <memory>
+
+// Mixes `v` into `seed`, for building RenderPass::inputs hashes.
+constexpr uint64_t hash_combine(uint64_t seed, uint64_t v) {
+    return seed ^ (v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+struct RenderPassStats {
+    size_t passes = 0;
+    size_t cached = 0; // passes in the cacheable prefix
+    size_t drawn = 0;  // passes that actually ran this frame
+    bool replayed = false;
+    bool clear_elided = false;
+    size_t rebuilds = 0; // times the cached output was redrawn, over the whole run
+    double gpu_ms = 0.0;
+};
+
+/**
+ * \brief Runs the registry's render passes for a frame. The leading run of cacheable passes is
+ * drawn into a pooled render target and only copied to the output while their inputs, the
+ * framebuffer size and the clear color stay the same. Only color is kept, so later passes can't
+ * depth test against cached geometry.
+ */
+class RenderPassRunner {
+  private:
+    std::shared_ptr<RenderTarget> cache;
+    uint64_t cached_inputs = 0;
+    GpuTimer<> timer;
+    RenderPassStats stats;
+
+  public:
+    // Draws into `fbo`, which must be bound with its viewport set to `width` x `height`.
+    void run(const vector<RenderPass> &passes, GLuint fbo, int width, int height,
+             const ImVec4 &clear, bool use_cache);
+    // Drops the cached output, the next frame redraws everything.
+    void invalidate();
+    const RenderPassStats &get_stats() const { return stats; }
+};
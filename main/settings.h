@@ -0,0 +1,109 @@
+#pragma once
+
+#include "konfig/konfig.h"
+
+// Config sections owned by the main loop rather than by a module, they are added once at startup
+// and modules reach them through mngr->getSection.
+
+struct frame_config {
+    int frames_in_flight = 2;
+    // waits for the GPU before polling input instead of after, trading throughput for latency
+    bool jit_input = false;
+    // cap on texture bytes streamed to the GPU per frame
+    int upload_budget_kb = 8192;
+    // replay the output of static passes instead of redrawing them
+    bool cache_passes = true;
+    // refreshes during a modal resize re-show the last frame instead of rendering a new one
+    bool blit_refresh = false;
+};
+
+#define FRAME_FIELDS(X)                                                                            \
+    X(frames_in_flight, "frames_in_flight")                                                        \
+    X(jit_input, "jit_input")                                                                      \
+    X(upload_budget_kb, "upload_budget_kb")                                                        \
+    X(cache_passes, "cache_passes")                                                                \
+    X(blit_refresh, "blit_refresh")
+
+MAKE_SECTION(frame_config, FRAME_FIELDS);
+
+struct texture_config {
+    // unused textures are evicted once the cache grows past this
+    int vram_budget_mb = 256;
+};
+
+#define TEXTURE_FIELDS(X) X(vram_budget_mb, "vram_budget_mb")
+
+MAKE_SECTION(texture_config, TEXTURE_FIELDS);
+
+struct resolution_config {
+    // scale the scene's resolution to keep its GPU time inside target_ms, the UI stays native
+    bool dynamic = false;
+    double target_ms = 12.0;
+    double min_scale = 0.5;
+    double max_scale = 1.0;
+};
+
+#define RESOLUTION_FIELDS(X)                                                                       \
+    X(dynamic, "dynamic")                                                                          \
+    X(target_ms, "target_ms")                                                                      \
+    X(min_scale, "min_scale")                                                                      \
+    X(max_scale, "max_scale")
+
+MAKE_SECTION(resolution_config, RESOLUTION_FIELDS);
+
+struct post_config {
+    // folds pointwise effects into the dispatch before them, off gives every effect its own
+    // dispatch and timer
+    bool fuse = true;
+    bool bloom = false;
+    double bloom_threshold = 0.8;
+    double bloom_intensity = 0.6;
+    bool blur = false;
+    int blur_radius = 4;
+    bool tonemap = false;
+    double exposure = 1.0;
+    bool grade = false;
+    double saturation = 1.0;
+    double contrast = 1.0;
+};
+
+#define POST_FIELDS(X)                                                                             \
+    X(fuse, "fuse")                                                                                \
+    X(bloom, "bloom")                                                                              \
+    X(bloom_threshold, "bloom_threshold")                                                          \
+    X(bloom_intensity, "bloom_intensity")                                                          \
+    X(blur, "blur")                                                                                \
+    X(blur_radius, "blur_radius")                                                                  \
+    X(tonemap, "tonemap")                                                                          \
+    X(exposure, "exposure")                                                                        \
+    X(grade, "grade")                                                                              \
+    X(saturation, "saturation")                                                                    \
+    X(contrast, "contrast")
+
+MAKE_SECTION(post_config, POST_FIELDS);
+
+struct cubes_config {
+    // instanced cube field drawn over the background, the standard throughput stress test
+    bool enabled = false;
+    int count = 100000;
+    bool gpu_cull = false; // cull in a compute shader and draw with multi-draw-indirect
+};
+
+#define CUBES_FIELDS(X)                                                                            \
+    X(enabled, "enabled")                                                                          \
+    X(count, "count")                                                                              \
+    X(gpu_cull, "gpu_cull")
+
+MAKE_SECTION(cubes_config, CUBES_FIELDS);
+
+struct sprites_config {
+    // bouncing quads submitted to the shared quad batch every frame
+    bool enabled = false;
+    int count = 10000;
+};
+
+#define SPRITES_FIELDS(X)                                                                          \
+    X(enabled, "enabled")                                                                          \
+    X(count, "count")
+
+MAKE_SECTION(sprites_config, SPRITES_FIELDS);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "config_manager.h"
+#include "graphics.h"
+#include "main.h"
+#include "module_registry.h"
+#include "settings.h"
+#include "opengl_helpers/quad_batch.hpp"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+/**
+ * \brief Sprites bouncing around the window, submitted to the shared QuadBatch every frame. The
+ * stress test for the many small quads overlays and effects draw.
+ */
+class SpriteField {
+  private:
+    struct Sprite {
+        glm::vec2 position; // fraction of the window, so resizing keeps them inside
+        glm::vec2 velocity; // window fractions per second
+        float rotation;
+        float spin;
+        float size; // pixels
+        glm::vec4 color;
+    };
+
+    static constexpr int MAX_SPRITES = 1'000'000;
+    // long stalls (dragging the window, breakpoints) shouldn't fling everything to the edges
+    static constexpr float MAX_STEP = 0.1f;
+
+    std::vector<Sprite> sprites;
+    double last_time = 0.0;
+
+    void populate(size_t count) {
+        std::mt19937 rng(4321);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> signed_unit(-1.0f, 1.0f);
+        sprites.resize(count);
+        for (auto &s : sprites) {
+            s.position = {unit(rng), unit(rng)};
+            s.velocity = glm::vec2(signed_unit(rng), signed_unit(rng)) * 0.2f;
+            s.rotation = unit(rng) * 6.2831853f;
+            s.spin = signed_unit(rng) * 3.0f;
+            s.size = 4.0f + unit(rng) * 12.0f;
+            s.color = {unit(rng), unit(rng), unit(rng), 0.8f};
+        }
+    }
+
+  public:
+    void update(State &ctx, const sprites_config &cfg) {
+        double now = glfwGetTime();
+        float dt = last_time == 0.0 ? 0.0f : static_cast<float>(now - last_time);
+        dt = std::min(dt, MAX_STEP);
+        last_time = now;
+
+        auto count = static_cast<size_t>(std::clamp(cfg.count, 0, MAX_SPRITES));
+        int w, h;
+        glfwGetFramebufferSize(ctx.w, &w, &h);
+        if (!cfg.enabled || count == 0 || !ctx.quads || w == 0 || h == 0)
+            return;
+        if (count != sprites.size())
+            populate(count);
+
+        glm::vec2 window(static_cast<float>(w), static_cast<float>(h));
+        for (auto &s : sprites) {
+            s.position += s.velocity * dt;
+            for (int k = 0; k < 2; ++k) {
+                if (s.position[k] < 0.0f || s.position[k] > 1.0f) {
+                    s.velocity[k] = -s.velocity[k];
+                    s.position[k] = std::clamp(s.position[k], 0.0f, 1.0f);
+                }
+            }
+            s.rotation += s.spin * dt;
+            ctx.quads->submit({
+                .position = s.position * window,
+                .size = glm::vec2(s.size),
+                .rotation = s.rotation,
+                .color = s.color,
+            });
+        }
+    }
+};
+
+void sprites_module(Registry &reg, State &ctx) {
+    auto cfg = mngr->getSection<sprites_config>("sprites");
+    if (!cfg)
+        return;
+    auto field = std::make_shared<SpriteField>();
+    // submitting is all a system does, main draws the batch once the render passes are done
+    reg.add_system([field, cfg, &ctx]() { field->update(ctx, cfg->data); });
+}
+REGISTER_MODULE(sprites_module);
@@ -0,0 +1,250 @@
+#include "transforms.h"
+#include "jobs.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if CPU_X86
+const TransformKernels &transform_kernels_avx2();
+#endif
+
+static void update_world_scalar(const glm::mat4 *local, const uint32_t *parent, glm::mat4 *world,
+                                size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+        world[i] = world[parent[i]] * local[i];
+}
+
+static const TransformKernels &transform_kernels_scalar() {
+    static const TransformKernels kernels{
+        .level = SimdLevel::scalar,
+        .update_world = update_world_scalar,
+    };
+    return kernels;
+}
+
+const TransformKernels &transform_kernels(SimdLevel level) {
+    level = std::min(level, best_simd_level());
+#if CPU_X86
+    if (level >= SimdLevel::avx2)
+        return transform_kernels_avx2();
+#endif
+    return transform_kernels_scalar();
+}
+
+TransformId TransformHierarchy::create(TransformId parent, const glm::mat4 &local) {
+    if (parent != NONE && !valid(parent))
+        throw std::runtime_error("Transform parent doesn't exist");
+
+    TransformId id;
+    if (!free_ids.empty()) {
+        id = free_ids.back();
+        free_ids.pop_back();
+    } else {
+        id = static_cast<TransformId>(nodes.size());
+        nodes.emplace_back();
+    }
+    // appended out of order for now, update() moves it to its depth
+    auto slot = static_cast<uint32_t>(ids.size());
+    nodes[id] = {parent, slot, false};
+    locals.push_back(local);
+    worlds.push_back(local);
+    parents.push_back(parent == NONE ? NONE : nodes[parent].slot);
+    first_child.push_back(0);
+    child_count.push_back(0);
+    ids.push_back(id);
+    dirty.push_back(0);
+    reorder = true;
+    return id;
+}
+
+void TransformHierarchy::destroy(TransformId id) {
+    if (!valid(id))
+        return;
+    nodes[id].destroyed = true;
+    reorder = true;
+}
+
+void TransformHierarchy::mark(uint32_t slot) {
+    if (!dirty[slot]) {
+        dirty[slot] = 1;
+        dirty_slots.push_back(slot);
+    }
+}
+
+void TransformHierarchy::set_local(TransformId id, const glm::mat4 &local) {
+    if (!valid(id))
+        return;
+    auto slot = nodes[id].slot;
+    locals[slot] = local;
+    mark(slot);
+}
+
+void TransformHierarchy::rebuild() {
+    size_t count = ids.size();
+
+    // children of every id in their current slot order, as offsets into one array
+    std::vector<uint32_t> offsets(nodes.size() + 1, 0), children(count);
+    std::vector<TransformId> order;
+    order.reserve(count);
+    for (auto id : ids) {
+        if (nodes[id].parent != NONE)
+            offsets[nodes[id].parent + 1]++;
+    }
+    for (size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+    auto fill = offsets;
+    for (auto id : ids) {
+        if (nodes[id].destroyed)
+            continue;
+        if (nodes[id].parent == NONE)
+            order.push_back(id);
+        else
+            children[fill[nodes[id].parent]++] = id;
+    }
+
+    // breadth first, which sorts each level by parent and leaves destroyed subtrees unreached
+    std::vector<uint32_t> new_first(count), new_count(count);
+    level_start.assign(1, 0);
+    for (size_t level_begin = 0; level_begin < order.size();) {
+        size_t level_end = order.size();
+        level_start.push_back(static_cast<uint32_t>(level_end));
+        for (size_t k = level_begin; k < level_end; ++k) {
+            TransformId id = order[k];
+            new_first[k] = static_cast<uint32_t>(order.size());
+            for (uint32_t c = offsets[id]; c < fill[id]; ++c) {
+                if (!nodes[children[c]].destroyed)
+                    order.push_back(children[c]);
+            }
+            new_count[k] = static_cast<uint32_t>(order.size()) - new_first[k];
+        }
+        level_begin = level_end;
+    }
+
+    std::vector<glm::mat4> new_locals(order.size());
+    std::vector<uint32_t> new_parents(order.size());
+    std::vector<uint32_t> old_slots(order.size());
+    for (size_t k = 0; k < order.size(); ++k)
+        old_slots[k] = nodes[order[k]].slot;
+    // anything the walk didn't reach was destroyed itself or sits below a destroyed node
+    for (auto id : ids) {
+        nodes[id].slot = NONE;
+        nodes[id].destroyed = false;
+    }
+    for (size_t k = 0; k < order.size(); ++k) {
+        auto &node = nodes[order[k]];
+        node.slot = static_cast<uint32_t>(k);
+        new_locals[k] = locals[old_slots[k]];
+        // parents come first, so theirs is already assigned
+        new_parents[k] = node.parent == NONE ? NONE : nodes[node.parent].slot;
+    }
+    for (auto id : ids) {
+        if (nodes[id].slot == NONE) {
+            nodes[id].parent = NONE;
+            free_ids.push_back(id);
+        }
+    }
+
+    locals = std::move(new_locals);
+    parents = std::move(new_parents);
+    first_child.assign(new_first.begin(), new_first.begin() + order.size());
+    child_count.assign(new_count.begin(), new_count.begin() + order.size());
+    ids = std::move(order);
+    worlds.resize(ids.size());
+    dirty.assign(ids.size(), 0);
+    dirty_slots.clear();
+    reorder = false;
+}
+
+void TransformHierarchy::update(const TransformKernels &kernels) {
+    auto start = std::chrono::steady_clock::now();
+    runs.clear();
+    if (reorder) {
+        rebuild();
+        stats.rebuilds++;
+        // every root is recomputed, which reaches everything below
+        if (level_start.size() > 1)
+            runs.push_back({0, level_start[1]});
+    } else {
+        std::sort(dirty_slots.begin(), dirty_slots.end());
+    }
+
+    stats.updated = 0;
+    size_t next_dirty = 0;
+    for (size_t level = 0; level + 1 < level_start.size(); ++level) {
+        uint32_t level_end = level_start[level + 1];
+
+        // runs inherited from the level above, merged with nodes marked on this one
+        next_runs.clear();
+        auto add = [this](Run run) {
+            if (!next_runs.empty() && run.begin <= next_runs.back().end)
+                next_runs.back().end = std::max(next_runs.back().end, run.end);
+            else
+                next_runs.push_back(run);
+        };
+        size_t r = 0;
+        while (r < runs.size() ||
+               (next_dirty < dirty_slots.size() && dirty_slots[next_dirty] < level_end)) {
+            bool marked = next_dirty < dirty_slots.size() && dirty_slots[next_dirty] < level_end;
+            if (marked && (r == runs.size() || dirty_slots[next_dirty] < runs[r].begin)) {
+                add({dirty_slots[next_dirty], dirty_slots[next_dirty] + 1});
+                next_dirty++;
+            } else {
+                add(runs[r++]);
+            }
+        }
+        if (next_runs.empty()) {
+            runs.clear();
+            if (next_dirty == dirty_slots.size())
+                break;
+            continue;
+        }
+
+        size_t total = 0;
+        for (auto &run : next_runs)
+            total += run.end - run.begin;
+        stats.updated += total;
+        if (level == 0) {
+            for (auto &run : next_runs)
+                std::copy(locals.begin() + run.begin, locals.begin() + run.end,
+                          worlds.begin() + run.begin);
+        } else if (total <= GRAIN) {
+            for (auto &run : next_runs)
+                kernels.update_world(locals.data(), parents.data(), worlds.data(), run.begin,
+                                     run.end);
+        } else {
+            jobs.clear();
+            for (auto &run : next_runs) {
+                for (uint32_t b = run.begin; b < run.end; b += GRAIN)
+                    jobs.push_back({b, std::min<uint32_t>(b + GRAIN, run.end)});
+            }
+            JobSystem::get().parallel_for(jobs.size(), 1, [this, &kernels](size_t b, size_t e) {
+                for (size_t j = b; j < e; ++j)
+                    kernels.update_world(locals.data(), parents.data(), worlds.data(),
+                                         jobs[j].begin, jobs[j].end);
+            });
+        }
+
+        // the children of a run are one run on the next level
+        runs.clear();
+        for (auto &run : next_runs) {
+            uint32_t begin = first_child[run.begin];
+            uint32_t end = first_child[run.end - 1] + child_count[run.end - 1];
+            if (begin == end)
+                continue;
+            if (!runs.empty() && runs.back().end == begin)
+                runs.back().end = end;
+            else
+                runs.push_back({begin, end});
+        }
+    }
+
+    for (auto slot : dirty_slots)
+        dirty[slot] = 0;
+    dirty_slots.clear();
+
+    stats.nodes = ids.size();
+    stats.levels = level_start.size() - 1;
+    stats.update_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+}
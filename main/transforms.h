@@ -0,0 +1,113 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "graphics.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using TransformId = uint32_t;
+
+/**
+ * \brief One implementation of the world matrix update. `update_world` sets
+ * world[i] = world[parent[i]] * local[i] for every i in [begin, end). Parents have to be outside
+ * the range and already up to date.
+ */
+struct TransformKernels {
+    SimdLevel level;
+    void (*update_world)(const glm::mat4 *local, const uint32_t *parent, glm::mat4 *world,
+                         size_t begin, size_t end);
+};
+
+// Kernels for `level`, or the best this CPU runs when `level` isn't supported.
+const TransformKernels &transform_kernels(SimdLevel level = best_simd_level());
+
+struct TransformStats {
+    size_t nodes = 0;
+    size_t levels = 0;
+    size_t updated = 0; // world matrices recomputed by the last update
+    size_t rebuilds = 0;
+    double update_ms = 0.0;
+};
+
+/**
+ * \brief Parent-child transforms stored as parallel arrays sorted by depth, and within a depth by
+ * parent, so the children of any run of nodes are themselves one run on the next level. Changing
+ * a local matrix marks the node dirty, update() then recomputes the runs below the dirty nodes
+ * level by level, each level split across the job system. Untouched subtrees cost nothing.
+ *
+ * Ids stay valid until the node is destroyed. Creating or destroying nodes reorders the arrays,
+ * which happens at the next update() and recomputes everything once.
+ */
+class TransformHierarchy {
+  public:
+    static constexpr TransformId NONE = ~0u;
+
+  private:
+    // nodes per job, levels with fewer dirty nodes than this are done on the calling thread
+    static constexpr size_t GRAIN = 4096;
+
+    struct Node {
+        TransformId parent = NONE;
+        uint32_t slot = NONE; // index into the arrays below, NONE for free ids
+        bool destroyed = false;
+    };
+
+    // by id
+    std::vector<Node> nodes;
+    std::vector<TransformId> free_ids;
+
+    // by slot, sorted by depth then parent
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint32_t> parents; // slot of the parent, NONE for roots
+    std::vector<uint32_t> first_child;
+    std::vector<uint32_t> child_count;
+    std::vector<TransformId> ids;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> level_start; // first slot of every depth, plus the end
+
+    std::vector<uint32_t> dirty_slots;     // marked since the last update, unsorted
+    bool reorder = false;                  // nodes were created or destroyed
+    struct Run {
+        uint32_t begin, end;
+    };
+    std::vector<Run> runs, next_runs, jobs; // scratch for update()
+    TransformStats stats;
+
+    void rebuild();
+    void mark(uint32_t slot);
+
+    uint32_t slot_of(TransformId id) const {
+        if (!valid(id))
+            throw std::runtime_error("Transform doesn't exist");
+        return nodes[id].slot;
+    }
+
+  public:
+    /**
+     * \brief Adds a node below `parent`, or a root for NONE. Its world matrix is valid after the
+     * next update().
+     */
+    TransformId create(TransformId parent = NONE, const glm::mat4 &local = glm::mat4(1.0f));
+    // Removes the node and everything below it at the next update().
+    void destroy(TransformId id);
+
+    // Ignored for ids that don't exist (anymore), like destroy().
+    void set_local(TransformId id, const glm::mat4 &local);
+    // Both throw for ids that don't exist (anymore).
+    const glm::mat4 &local(TransformId id) const { return locals[slot_of(id)]; }
+    // As of the last update().
+    const glm::mat4 &world(TransformId id) const { return worlds[slot_of(id)]; }
+    TransformId parent(TransformId id) const { return valid(id) ? nodes[id].parent : NONE; }
+    bool valid(TransformId id) const {
+        return id < nodes.size() && nodes[id].slot != NONE && !nodes[id].destroyed;
+    }
+
+    // Applies structural changes and recomputes what moved. Main calls it once per frame.
+    void update(const TransformKernels &kernels = transform_kernels());
+
+    size_t size() const { return ids.size(); }
+    const TransformStats &get_stats() const { return stats; }
+};
@@ -0,0 +1,47 @@
+#include "transforms.h"
+
+#if CPU_X86
+// Same rules as image_kernels_avx2.cpp: includes first, then AVX2 for the kernels only.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+
+// Two columns of the product per register: each column of the parent is broadcast to both lanes
+// and scaled by the matching element of two local columns at once.
+static void update_world_avx2(const glm::mat4 *local, const uint32_t *parent, glm::mat4 *world,
+                              size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const float *p = &world[parent[i]][0][0];
+        const float *l = &local[i][0][0];
+        __m256 p0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(p));
+        __m256 p1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(p + 4));
+        __m256 p2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(p + 8));
+        __m256 p3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(p + 12));
+        float *w = &world[i][0][0];
+        for (int half = 0; half < 2; ++half) {
+            __m256 c = _mm256_loadu_ps(l + half * 8);
+            __m256 r = _mm256_mul_ps(p0, _mm256_permute_ps(c, 0x00));
+            r = _mm256_fmadd_ps(p1, _mm256_permute_ps(c, 0x55), r);
+            r = _mm256_fmadd_ps(p2, _mm256_permute_ps(c, 0xaa), r);
+            r = _mm256_fmadd_ps(p3, _mm256_permute_ps(c, 0xff), r);
+            _mm256_storeu_ps(w + half * 8, r);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+const TransformKernels &transform_kernels_avx2() {
+    static const TransformKernels kernels{
+        .level = SimdLevel::avx2,
+        .update_world = update_world_avx2,
+    };
+    return kernels;
+}
+#endif
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "graphics.h"
+#include <initializer_list>
 #include <stdexcept>
+#include <string>
 
 /**
  * \brief Creates a new shader program and links a vertex and fragment shader to it.
@@ -35,6 +37,31 @@ inline GLuint linkModules(const GLuint vertexModule, const GLuint fragmentModule
     return program;
 }
 
+/**
+ * \brief Creates a new shader program from any set of shader modules, e.g. a single compute shader.
+ * \param modules The shader modules to link.
+ * \return Returns the linked shader program.
+ */
+inline GLuint linkModules(std::initializer_list<GLuint> modules) {
+    const GLuint program = glCreateProgram();
+    for (auto module : modules)
+        glAttachShader(program, module);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLint size;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+        std::string log(size, '\0');
+        glGetProgramInfoLog(program, size, nullptr, log.data());
+        glDeleteProgram(program);
+        throw std::runtime_error("Failed to link GL shader program.\n" + log);
+    }
+
+    return program;
+}
+
 /**
  * \brief Creates and compiles a shader module.
  * \param type The type of shader to create, e.g. GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
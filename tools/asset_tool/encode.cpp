@@ -0,0 +1,107 @@
+#include "encode.h"
+#include "image_decode.h"
+#include <algorithm>
+#include <cstring>
+
+std::vector<Rgba8Image> build_mip_chain(Rgba8Image base, bool srgb, MipFilter filter) {
+    auto mips = build_mip_levels(base.pixels.data(), base.width, base.height, srgb, filter);
+    std::vector<Rgba8Image> levels;
+    levels.reserve(mips.size() + 1);
+    levels.push_back(std::move(base));
+    for (auto &pixels : mips) {
+        auto &prev = levels.back();
+        levels.push_back({std::max(1u, prev.width / 2), std::max(1u, prev.height / 2),
+                          std::move(pixels)});
+    }
+    return levels;
+}
+
+static uint16_t to_565(const int c[3]) {
+    return static_cast<uint16_t>((c[0] * 31 + 127) / 255 << 11 | (c[1] * 63 + 127) / 255 << 5 |
+                                 (c[2] * 31 + 127) / 255);
+}
+
+static void from_565(uint16_t v, int c[3]) {
+    int r = v >> 11 & 31, g = v >> 5 & 63, b = v & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+static void encode_block(const uint8_t block[16][4], std::byte out[8]) {
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            lo[c] = std::min<int>(lo[c], block[i][c]);
+            hi[c] = std::max<int>(hi[c], block[i][c]);
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+
+    // pick the bounding box diagonal that follows the colors: flip green and blue when they
+    // correlate negatively with red
+    float rg = 0, rb = 0;
+    for (int i = 0; i < 16; ++i) {
+        float dr = block[i][0] - mean[0];
+        rg += dr * (block[i][1] - mean[1]);
+        rb += dr * (block[i][2] - mean[2]);
+    }
+    if (rg < 0)
+        std::swap(lo[1], hi[1]);
+    if (rb < 0)
+        std::swap(lo[2], hi[2]);
+
+    uint16_t c0 = to_565(hi), c1 = to_565(lo);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        from_565(c0, palette[0]);
+        from_565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDist = INT32_MAX;
+            for (int p = 0; p < 4; ++p) {
+                int dist = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= uint32_t(best) << (i * 2);
+        }
+    }
+
+    std::memcpy(out, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+std::vector<std::byte> encode_bc1(const Rgba8Image &img) {
+    uint32_t bw = (img.width + 3) / 4, bh = (img.height + 3) / 4;
+    std::vector<std::byte> out(size_t(bw) * bh * 8);
+    auto *in = reinterpret_cast<const uint8_t *>(img.pixels.data());
+
+    uint8_t block[16][4];
+    for (uint32_t by = 0; by < bh; ++by) {
+        for (uint32_t bx = 0; bx < bw; ++bx) {
+            for (uint32_t i = 0; i < 16; ++i) {
+                uint32_t x = std::min(bx * 4 + i % 4, img.width - 1);
+                uint32_t y = std::min(by * 4 + i / 4, img.height - 1);
+                std::memcpy(block[i], in + (size_t(y) * img.width + x) * 4, 4);
+            }
+            encode_block(block, out.data() + (size_t(by) * bw + bx) * 8);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "image_kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct Rgba8Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::byte> pixels; // tightly packed RGBA8 rows
+};
+
+/**
+ * \brief Builds every level down to 1x1, level 0 is `base` itself. With `srgb` the filtering
+ * happens in linear space so dark and bright regions keep their brightness.
+ */
+std::vector<Rgba8Image> build_mip_chain(Rgba8Image base, bool srgb, MipFilter filter);
+
+/**
+ * \brief Encodes RGBA8 into BC1 blocks without alpha. Endpoints are fitted along the bounding box
+ * diagonal of each 4x4 block, edge blocks are padded by clamping.
+ */
+std::vector<std::byte> encode_bc1(const Rgba8Image &img);
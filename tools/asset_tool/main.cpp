@@ -0,0 +1,218 @@
+// asset_tool: offline conversion of source assets into the formats the runtime loads directly.
+//
+//   asset_tool ktx2 <in.png> <out.ktx2> [--bc1] [--srgb] [--kaiser] [--premultiply]
+//   asset_tool qoi <in.png> <out.qoi>
+//   asset_tool raw <in.png> <out.rgba> [--srgb] [--kaiser] [--premultiply]
+//   asset_tool pack <out.pak> <file or directory>...
+//
+// Run from main/ to refresh the shipped assets, e.g.
+//   asset_tool ktx2 assets/background.png assets/background.ktx2
+//   asset_tool pack assets.pak assets
+// Pack paths are stored exactly as passed, so they match what the runtime asks for.
+
+#include "asset_pack.h"
+#include "encode.h"
+#include "image_decode.h"
+#include "ktx2.h"
+#include "qoi.h"
+#include "stb/stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using Args = std::vector<std::string_view>;
+
+static bool has_flag(const Args &args, std::string_view flag) {
+    return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+static Args positional(const Args &args) {
+    Args out;
+    for (auto a : args) {
+        if (!a.starts_with("--"))
+            out.push_back(a);
+    }
+    return out;
+}
+
+static Rgba8Image load_png(const std::string &path, bool flip = true) {
+    // GL's bottom-up row order by default, the runtime uploads rows exactly as stored
+    stbi_set_flip_vertically_on_load(flip);
+    int w, h, ch;
+    auto *data = stbi_load(path.c_str(), &w, &h, &ch, 4);
+    if (!data)
+        throw std::runtime_error("failed to load " + path + ": " + stbi_failure_reason());
+
+    Rgba8Image img;
+    img.width = static_cast<uint32_t>(w);
+    img.height = static_cast<uint32_t>(h);
+    img.pixels.resize(size_t(w) * h * 4);
+    std::memcpy(img.pixels.data(), data, img.pixels.size());
+    stbi_image_free(data);
+    return img;
+}
+
+static MipFilter mip_filter(const Args &args) {
+    return has_flag(args, "--kaiser") ? MipFilter::kaiser : MipFilter::box;
+}
+
+// Loads a PNG for mip generation, premultiplied first if asked so the mips filter correctly.
+static Rgba8Image load_source(const Args &args, std::string_view path, bool srgb) {
+    auto img = load_png(std::string(path));
+    if (has_flag(args, "--premultiply"))
+        image_kernels().premultiply_alpha(reinterpret_cast<uint8_t *>(img.pixels.data()),
+                                          size_t(img.width) * img.height, srgb);
+    return img;
+}
+
+static void write_file(const std::string &path, std::span<const std::byte> data) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("failed to open " + path + " for writing");
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+static std::vector<std::byte> read_file(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        throw std::runtime_error("failed to open " + path.string());
+    std::vector<std::byte> data(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(data.data()), data.size());
+    return data;
+}
+
+static int cmd_pack(const Args &args) {
+    namespace fs = std::filesystem;
+    auto files = positional(args);
+    if (files.size() < 2) {
+        std::cerr << "usage: asset_tool pack <out.pak> <file or directory>...\n";
+        return 1;
+    }
+    fs::path output(files[0]);
+
+    std::vector<fs::path> paths;
+    for (size_t i = 1; i < files.size(); ++i) {
+        fs::path root(files[i]);
+        if (!fs::is_directory(root)) {
+            paths.push_back(root);
+            continue;
+        }
+        for (auto &entry : fs::recursive_directory_iterator(root)) {
+            // the output may live inside the packed directory, an earlier pack isn't an asset
+            std::error_code ec;
+            if (entry.is_regular_file() && !fs::equivalent(entry.path(), output, ec))
+                paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<PackInput> inputs;
+    size_t total = 0;
+    for (auto &path : paths) {
+        inputs.push_back({path.generic_string(), read_file(path)});
+        total += inputs.back().data.size();
+    }
+    auto pack = write_asset_pack(inputs);
+    write_file(output.string(), pack);
+
+    std::cout << output.string() << ": " << inputs.size() << " assets, " << total
+              << " payload bytes, " << pack.size() << " bytes\n";
+    return 0;
+}
+
+static int cmd_ktx2(const Args &args) {
+    auto files = positional(args);
+    if (files.size() != 2) {
+        std::cerr << "usage: asset_tool ktx2 <in.png> <out.ktx2> [--bc1] [--srgb] [--kaiser] "
+                     "[--premultiply]\n";
+        return 1;
+    }
+    bool bc1 = has_flag(args, "--bc1");
+    bool srgb = has_flag(args, "--srgb");
+
+    auto mips = build_mip_chain(load_source(args, files[0], srgb), srgb, mip_filter(args));
+    std::vector<std::vector<std::byte>> levels;
+    levels.reserve(mips.size());
+    for (auto &level : mips)
+        levels.push_back(bc1 ? encode_bc1(level) : std::move(level.pixels));
+
+    VkFormat format = bc1 ? (srgb ? VkFormat::bc1_rgb_srgb : VkFormat::bc1_rgb_unorm)
+                          : (srgb ? VkFormat::r8g8b8a8_srgb : VkFormat::r8g8b8a8_unorm);
+    auto file = write_ktx2(format, mips[0].width, mips[0].height, levels);
+    write_file(std::string(files[1]), file);
+
+    std::cout << files[1] << ": " << mips[0].width << "x" << mips[0].height << ", "
+              << levels.size() << " levels, " << file.size() << " bytes\n";
+    return 0;
+}
+
+static int cmd_qoi(const Args &args) {
+    auto files = positional(args);
+    if (files.size() != 2) {
+        std::cerr << "usage: asset_tool qoi <in.png> <out.qoi>\n";
+        return 1;
+    }
+    // QOI files are top-down per the spec, the runtime flips while decoding
+    auto img = load_png(std::string(files[0]), false);
+    auto file = qoi_encode(img.pixels, img.width, img.height);
+    write_file(std::string(files[1]), file);
+
+    std::cout << files[1] << ": " << img.width << "x" << img.height << ", " << file.size()
+              << " bytes\n";
+    return 0;
+}
+
+static int cmd_raw(const Args &args) {
+    auto files = positional(args);
+    if (files.size() != 2) {
+        std::cerr << "usage: asset_tool raw <in.png> <out.rgba> [--srgb] [--kaiser] "
+                     "[--premultiply]\n";
+        return 1;
+    }
+    bool srgb = has_flag(args, "--srgb");
+
+    auto mips = build_mip_chain(load_source(args, files[0], srgb), srgb, mip_filter(args));
+    std::vector<std::vector<std::byte>> levels;
+    levels.reserve(mips.size());
+    for (auto &level : mips)
+        levels.push_back(std::move(level.pixels));
+    auto file = write_raw_image(mips[0].width, mips[0].height, srgb, levels);
+    write_file(std::string(files[1]), file);
+
+    std::cout << files[1] << ": " << mips[0].width << "x" << mips[0].height << ", "
+              << levels.size() << " levels, " << file.size() << " bytes\n";
+    return 0;
+}
+
+static const std::map<std::string_view, std::function<int(const Args &)>> commands = {
+    {"ktx2", cmd_ktx2},
+    {"qoi", cmd_qoi},
+    {"raw", cmd_raw},
+    {"pack", cmd_pack},
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2 || !commands.contains(argv[1])) {
+        std::cerr << "usage: asset_tool <command> [args...]\ncommands:";
+        for (auto &[name, _] : commands)
+            std::cerr << " " << name;
+        std::cerr << "\n";
+        return 1;
+    }
+
+    Args args(argv + 2, argv + argc);
+    try {
+        return commands.at(argv[1])(args);
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+}